@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    DSPerformanceCounters.cpp
+    Created: 19 Oct 2026 4:22:50am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSPerformanceCounters.h"
+
+#if JUCE_LINUX
+ #include <cerrno>
+ #include <cstring>
+ #include <linux/perf_event.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+const char *DSPerformanceCounters::getEventName(Event event) {
+    switch (event) {
+        case eventInstructions: return "instructions";
+        case eventCycles:       return "cycles";
+        case eventCacheMisses:  return "cacheMisses";
+        case eventBranchMisses: return "branchMisses";
+        default:                return "";
+    }
+}
+
+DSPerformanceCounters::~DSPerformanceCounters() {
+#if JUCE_LINUX
+    for (auto &thread : threads) {
+        for (int fileDescriptor : thread.fileDescriptors) {
+            if(fileDescriptor >= 0) {
+                close(fileDescriptor);
+            }
+        }
+    }
+#endif
+}
+
+void DSPerformanceCounters::openThreadCounters(ThreadCounters &counters) {
+#if JUCE_LINUX
+    static const juce::uint64 configs[numEvents] = {
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for (int event = 0; event < numEvents; event++) {
+        perf_event_attr attributes;
+        memset(&attributes, 0, sizeof(attributes));
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.size = sizeof(attributes);
+        attributes.config = configs[event];
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+
+        // A pid of 0 without inherit counts only the calling thread
+        counters.fileDescriptors[event] = (int) syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+    }
+#else
+    for (int event = 0; event < numEvents; event++) {
+        counters.fileDescriptors[event] = -1;
+    }
+#endif
+}
+
+bool DSPerformanceCounters::open() {
+#if JUCE_LINUX
+    ThreadCounters counters;
+    openThreadCounters(counters);
+    if(counters.fileDescriptors[eventInstructions] < 0) {
+        error = juce::String("perf_event_open failed: ") + strerror(errno);
+        for (int fileDescriptor : counters.fileDescriptors) {
+            if(fileDescriptor >= 0) {
+                close(fileDescriptor);
+            }
+        }
+        return false;
+    }
+    const juce::ScopedLock scopedLock(lock);
+    threads.add(counters);
+    opened = true;
+    return true;
+#else
+    error = "Performance counters are only read on Linux.";
+    return false;
+#endif
+}
+
+void DSPerformanceCounters::addCurrentThread() {
+    if(!opened) {
+        return;
+    }
+    ThreadCounters counters;
+    openThreadCounters(counters);
+    const juce::ScopedLock scopedLock(lock);
+    threads.add(counters);
+}
+
+void DSPerformanceCounters::read(juce::int64 (&values)[numEvents], bool addedThreadsOnly) const {
+    const juce::ScopedLock scopedLock(lock);
+    for (int event = 0; event < numEvents; event++) {
+        // Events the CPU doesn't have couldn't be opened for the first thread either
+        values[event] = (threads.isEmpty() || threads.getReference(0).fileDescriptors[event] < 0) ? -1 : 0;
+#if JUCE_LINUX
+        for (int thread = addedThreadsOnly ? 1 : 0; thread < threads.size() && values[event] >= 0; thread++) {
+            int fileDescriptor = threads.getReference(thread).fileDescriptors[event];
+            juce::uint64 value = 0;
+            if(fileDescriptor >= 0 && ::read(fileDescriptor, &value, sizeof(value)) == (ssize_t) sizeof(value)) {
+                values[event] += (juce::int64) value;
+            }
+        }
+#endif
+    }
+}
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    DSPerformanceCounters.h
+    Created: 19 Oct 2026 4:22:50am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Hardware performance counters for the whole process, read through perf_event_open
+// (Linux only). Instruction counts barely move between runs on a busy machine, so they
+// make a far steadier regression signal than wall-clock time.
+//
+// perf_event counters are per thread, and an inherited counter only adds a thread's counts
+// to its parent's once the thread exits, which long-lived pool threads never do before the
+// end of a run. So open() counts the calling thread, every other thread that should be
+// counted calls addCurrentThread() (see DSConversionScheduler::setThreadStartCallback), and
+// read() adds them all up. Only user-space events are counted, which works with the default
+// perf_event_paranoid setting.
+class DSPerformanceCounters {
+public:
+    enum Event {
+        eventInstructions,
+        eventCycles,
+        eventCacheMisses,
+        eventBranchMisses,
+        numEvents
+    };
+
+    DSPerformanceCounters() {}
+    ~DSPerformanceCounters();
+
+    static const char *getEventName(Event event);
+
+    // Returns false (with the reason in getError()) if the counters can't be used, e.g. on
+    // another OS, inside a container without access, or in a VM without a PMU. Events the
+    // CPU doesn't have are left out; read() reports them as -1.
+    bool open();
+    bool isOpen() const { return opened; }
+    const juce::String &getError() const { return error; }
+
+    // Counts the calling thread too. Does nothing unless open() succeeded.
+    void addCurrentThread();
+
+    // Reads the running totals of every event, summed over the counted threads, or over the
+    // threads added with addCurrentThread() only
+    void read(juce::int64 (&values)[numEvents], bool addedThreadsOnly = false) const;
+
+private:
+    struct ThreadCounters {
+        int fileDescriptors[numEvents];
+    };
+    static void openThreadCounters(ThreadCounters &counters);
+
+    juce::CriticalSection lock;
+    // The thread that called open() comes first
+    juce::Array<ThreadCounters> threads;
+    bool opened = false;
+    juce::String error;
+
+    JUCE_DECLARE_NON_COPYABLE (DSPerformanceCounters)
+};
@@ -0,0 +1,203 @@
+/*
+  ==============================================================================
+
+    DSSyntheticInstrument.cpp
+    Created: 18 Oct 2026 11:02:44pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSSyntheticInstrument.h"
+
+// Long enough that the loop and its crossfade fit comfortably after the start point
+static const int minimumSampleFrames = 2048;
+static const int loopCrossfadeMilliseconds = 5;
+
+bool DSSyntheticInstrument::write(const DSSyntheticInstrumentSpec &spec, const juce::File &directory, const juce::String &name, juce::File &exsFile) {
+    juce::File sampleDirectory = directory.getChildFile(name);
+    if(!sampleDirectory.createDirectory().wasOk()) {
+        std::cerr << "Unable to create \"" << sampleDirectory.getFullPathName() << "\"." << std::endl;
+        return false;
+    }
+    
+    for (int i = 0; i < spec.numSamples; i++) {
+        if(!writeSample(spec, sampleDirectory.getChildFile(getSampleFileName(i)), i)) {
+            return false;
+        }
+    }
+    
+    DSEXS24 exs = createInstrument(spec, sampleDirectory, name);
+    exsFile = directory.getChildFile(name + ".exs");
+    if(!exs.saveExs(exsFile, spec.bigEndian, spec.sampleChunkSize)) {
+        std::cerr << "Unable to write \"" << exsFile.getFullPathName() << "\"." << std::endl;
+        return false;
+    }
+    
+    // Whatever is benchmarked has to be what was meant to be generated
+    DSEXS24 loaded;
+    juce::String difference = loaded.loadExs(exsFile) ? compare(exs, loaded) : juce::String("it could not be loaded");
+    if(difference.isNotEmpty()) {
+        std::cerr << "\"" << exsFile.getFullPathName() << "\" did not round-trip: " << difference << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+juce::String DSSyntheticInstrument::getSampleFileName(int sampleIndex) {
+    return "Sample " + juce::String(sampleIndex + 1).paddedLeft('0', 5) + (sampleIndex % 2 == 0 ? ".wav" : ".aif");
+}
+
+bool DSSyntheticInstrument::writeSample(const DSSyntheticInstrumentSpec &spec, const juce::File &sampleFile, int sampleIndex) {
+    std::unique_ptr<juce::AudioFormat> audioFormat;
+    if(sampleFile.hasFileExtension("wav")) {
+        audioFormat.reset(new juce::WavAudioFormat());
+    } else {
+        audioFormat.reset(new juce::AiffAudioFormat());
+    }
+    
+    std::unique_ptr<juce::FileOutputStream> outputStream = sampleFile.createOutputStream();
+    if(outputStream == nullptr || !outputStream->truncate().wasOk()) {
+        std::cerr << "Unable to write \"" << sampleFile.getFullPathName() << "\"." << std::endl;
+        return false;
+    }
+    std::unique_ptr<juce::AudioFormatWriter> writer (audioFormat->createWriterFor(outputStream.get(), spec.sampleRate, (unsigned int) spec.numChannels, spec.bitsPerSample, {}, 0));
+    if(writer == nullptr) {
+        std::cerr << "Unable to write \"" << sampleFile.getFullPathName() << "\"." << std::endl;
+        return false;
+    }
+    outputStream.release();
+    
+    // A decaying sine, a different pitch for every sample
+    int numFrames = juce::jmax(minimumSampleFrames, spec.sampleFrames);
+    double frequency = 110.0 * std::pow(2.0, (sampleIndex % 48) / 12.0);
+    juce::AudioBuffer<float> buffer (spec.numChannels, numFrames);
+    for (int channel = 0; channel < spec.numChannels; channel++) {
+        float *samples = buffer.getWritePointer(channel);
+        for (int frame = 0; frame < numFrames; frame++) {
+            double envelope = 1.0 - 0.5 * frame / numFrames;
+            samples[frame] = (float) (0.5 * envelope * std::sin(2.0 * juce::MathConstants<double>::pi * frequency * frame / spec.sampleRate));
+        }
+    }
+    return writer->writeFromAudioSampleBuffer(buffer, 0, numFrames);
+}
+
+DSEXS24 DSSyntheticInstrument::createInstrument(const DSSyntheticInstrumentSpec &spec, const juce::File &sampleDirectory, const juce::String &name) {
+    DSEXS24 exs;
+    exs.setName(name);
+    int numFrames = juce::jmax(minimumSampleFrames, spec.sampleFrames);
+    int numGroups = juce::jmax(1, spec.numGroups);
+    int numSamples = juce::jmax(1, spec.numSamples);
+    int roundRobinLength = juce::jmax(1, spec.roundRobinLength);
+    
+    for (int i = 0; i < numSamples; i++) {
+        DSEXS24Sample sample;
+        sample.id = i;
+        sample.fileName = getSampleFileName(i);
+        sample.name = sample.fileName;
+        sample.filePath = sampleDirectory.getFullPathName();
+        sample.length = numFrames;
+        sample.sampleRate = spec.sampleRate;
+        sample.bitDepth = (short) spec.bitsPerSample;
+        sample.type = 0;
+        exs.getSamples().add(sample);
+    }
+    
+    for (int i = 0; i < numGroups; i++) {
+        DSEXS24Group group;
+        group.name = name + " Group " + juce::String(i + 1);
+        group.polyphony = 0;
+        group.velRangeLow = 0;
+        group.velRangeHigh = 127;
+        group.trigger = 0;
+        group.output = 0;
+        // Each group points at the next one in its round robin, and the last one ends the chain
+        bool lastInChain = (i % roundRobinLength) == roundRobinLength - 1 || i == numGroups - 1;
+        group.exsSequence = lastInChain ? -1 : i + 1;
+        group.seqNumber = 0;
+        exs.getGroups().add(group);
+    }
+    
+    // Zones are dealt out across the groups and then up the keyboard, so that every group
+    // ends up with a spread of keys
+    for (int i = 0; i < spec.numZones; i++) {
+        DSEXS24Zone zone;
+        zone.id = i;
+        zone.name = name + " Zone " + juce::String(i + 1);
+        zone.pitch = true;
+        zone.oneShot = false;
+        zone.reverse = false;
+        zone.key = (short) (21 + (i / numGroups) % 88);
+        // Small negative values too, so that the signed fields get exercised
+        zone.fineTuning = (short) ((i % 11) - 5);
+        zone.coarseTuning = 0;
+        zone.pan = (short) ((i % 9) - 4);
+        zone.volume = -0.5f * (i % 7);
+        zone.keyLow = zone.key;
+        zone.keyHigh = zone.key;
+        zone.velocityRangeOn = false;
+        zone.loVel = 0;
+        zone.hiVel = 127;
+        zone.sampleStart = 0;
+        zone.sampleEnd = numFrames;
+        zone.loopEnabled = (i % 2) == 0;
+        zone.loopStart = zone.loopEnabled ? numFrames / 2 : 0;
+        zone.loopEnd = zone.loopEnabled ? numFrames - numFrames / 8 : 0;
+        zone.loopCrossfadeMilliseconds = zone.loopEnabled ? loopCrossfadeMilliseconds : 0;
+        zone.loopEqualPower = (i % 4) == 0;
+        zone.output = -1;
+        zone.groupIndex = i % numGroups;
+        zone.sampleIndex = i % numSamples;
+        zone.sampleFade = 0;
+        zone.offset = 0;
+        exs.getZones().add(zone);
+    }
+    return exs;
+}
+
+juce::String DSSyntheticInstrument::compare(DSEXS24 &expected, DSEXS24 &loaded) {
+    if(expected.getName() != loaded.getName()) {
+        return "the instrument name differs";
+    }
+    if(expected.getZones().size() != loaded.getZones().size()
+       || expected.getGroups().size() != loaded.getGroups().size()
+       || expected.getSamples().size() != loaded.getSamples().size()) {
+        return "the number of zones, groups or samples differs";
+    }
+    
+    for (int i = 0; i < expected.getZones().size(); i++) {
+        const DSEXS24Zone &a = expected.getZones().getReference(i);
+        const DSEXS24Zone &b = loaded.getZones().getReference(i);
+        if(a.id != b.id || a.name != b.name || a.pitch != b.pitch || a.oneShot != b.oneShot || a.reverse != b.reverse
+           || a.key != b.key || a.fineTuning != b.fineTuning || a.pan != b.pan || a.volume != b.volume
+           || a.coarseTuning != b.coarseTuning || a.keyLow != b.keyLow || a.keyHigh != b.keyHigh
+           || a.velocityRangeOn != b.velocityRangeOn || a.loVel != b.loVel || a.hiVel != b.hiVel
+           || a.sampleStart != b.sampleStart || a.sampleEnd != b.sampleEnd || a.loopStart != b.loopStart
+           || a.loopEnd != b.loopEnd || a.loopCrossfadeMilliseconds != b.loopCrossfadeMilliseconds
+           || a.loopEnabled != b.loopEnabled || a.loopEqualPower != b.loopEqualPower || a.output != b.output
+           || a.groupIndex != b.groupIndex || a.sampleIndex != b.sampleIndex
+           || a.sampleFade != b.sampleFade || a.offset != b.offset) {
+            return "zone " + juce::String(i) + " differs";
+        }
+    }
+    
+    for (int i = 0; i < expected.getGroups().size(); i++) {
+        const DSEXS24Group &a = expected.getGroups().getReference(i);
+        const DSEXS24Group &b = loaded.getGroups().getReference(i);
+        if(a.name != b.name || a.volume != b.volume || a.pan != b.pan || a.polyphony != b.polyphony
+           || a.velRangeLow != b.velRangeLow || a.velRangeHigh != b.velRangeHigh
+           || a.trigger != b.trigger || a.output != b.output || a.exsSequence != b.exsSequence) {
+            return "group " + juce::String(i) + " differs";
+        }
+    }
+    
+    for (int i = 0; i < expected.getSamples().size(); i++) {
+        const DSEXS24Sample &a = expected.getSamples().getReference(i);
+        const DSEXS24Sample &b = loaded.getSamples().getReference(i);
+        if(a.id != b.id || a.fileName != b.fileName || a.filePath != b.filePath || a.length != b.length
+           || a.sampleRate != b.sampleRate || a.bitDepth != b.bitDepth || a.type != b.type) {
+            return "sample " + juce::String(i) + " differs";
+        }
+    }
+    return {};
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    DSSyntheticInstrument.h
+    Created: 18 Oct 2026 11:02:44pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Source/DSEXS24.h"
+
+struct DSSyntheticInstrumentSpec {
+    int numZones = 100;
+    int numGroups = 1;
+    // Once there are more zones than samples, zones share samples in turn
+    int numSamples = 100;
+    int sampleFrames = 8192;
+    int sampleRate = 44100;
+    int numChannels = 1;
+    int bitsPerSample = 16;
+    // Groups are chained into round robins of this many; 1 leaves them all independent
+    int roundRobinLength = 1;
+    bool bigEndian = false;
+    // One of the sample chunk sizes DSEXS24::isValidSampleChunkSize accepts
+    int sampleChunkSize = 592;
+};
+
+// Generates EXS instruments of any size for benchmarking, along with the samples they
+// play. Every other zone loops with a crossfade so that the whole pipeline gets exercised.
+class DSSyntheticInstrument {
+public:
+    // Writes <name>.exs into directory and its samples into directory/<name>/, alternating
+    // between WAV and AIFF, where huntForSamples will find them.
+    static bool write(const DSSyntheticInstrumentSpec &spec, const juce::File &directory, const juce::String &name, juce::File &exsFile);
+    
+    static DSEXS24 createInstrument(const DSSyntheticInstrumentSpec &spec, const juce::File &sampleDirectory, const juce::String &name);
+    static juce::String getSampleFileName(int sampleIndex);
+    static bool writeSample(const DSSyntheticInstrumentSpec &spec, const juce::File &sampleFile, int sampleIndex);
+    
+    // Describes the first field that didn't survive a save and load, or returns an empty
+    // string if everything did. Sample names are left out since the smallest sample chunk
+    // has no room for them.
+    static juce::String compare(DSEXS24 &expected, DSEXS24 &loaded);
+};
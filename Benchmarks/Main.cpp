@@ -0,0 +1,463 @@
+/*
+  ==============================================================================
+
+    Times each stage of the conversion pipeline on synthetic instruments and
+    reports the results as JSON, so that runs before and after a change can be
+    compared.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/DSEXS24.h"
+#include "../Source/DSPresetConverter.h"
+#include "../Source/DSSampleResolver.h"
+#include "../Source/DSInstrumentation.h"
+#include "../Source/DSAllocationTracker.h"
+#include "DSSyntheticInstrument.h"
+#include "DSPerformanceCounters.h"
+#include <tclap/CmdLine.h>
+
+// The pipeline stages, in the order the converter runs them
+static const char *const stageNames[] = {
+    "loadExs",
+    "parseDSEXS24",
+    "huntForSamples",
+    "convertEXSLoopCrossfadePoints",
+    "copySamplesOverToNewDirectory",
+    "getSFZ"
+};
+static const int numStages = (int) (sizeof(stageNames) / sizeof(stageNames[0]));
+
+// What was measured of one stage, one entry per repetition
+struct StageSamples {
+    juce::Array<double> seconds;
+    juce::Array<double> events[DSPerformanceCounters::numEvents];
+    // The part of the instructions that ran on the scheduler's pool threads
+    juce::Array<double> poolInstructions;
+};
+
+// Measures the wall time of a scope and, if the counters are open, how far each one moved
+class ScopedStageMeasurement {
+public:
+    ScopedStageMeasurement(StageSamples &samples_, const DSPerformanceCounters &counters_)
+        : samples(samples_), counters(counters_) {
+        if(counters.isOpen()) {
+            counters.read(startEvents);
+            counters.read(startPoolEvents, true);
+        }
+        startTicks = juce::Time::getHighResolutionTicks();
+    }
+    ~ScopedStageMeasurement() {
+        samples.seconds.add(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks));
+        if(counters.isOpen()) {
+            juce::int64 endEvents[DSPerformanceCounters::numEvents];
+            juce::int64 endPoolEvents[DSPerformanceCounters::numEvents];
+            counters.read(endEvents);
+            counters.read(endPoolEvents, true);
+            for (int event = 0; event < DSPerformanceCounters::numEvents; event++) {
+                if(startEvents[event] >= 0 && endEvents[event] >= 0) {
+                    samples.events[event].add((double) (endEvents[event] - startEvents[event]));
+                }
+            }
+            samples.poolInstructions.add((double) (endPoolEvents[DSPerformanceCounters::eventInstructions] - startPoolEvents[DSPerformanceCounters::eventInstructions]));
+        }
+    }
+private:
+    StageSamples &samples;
+    const DSPerformanceCounters &counters;
+    juce::int64 startEvents[DSPerformanceCounters::numEvents];
+    juce::int64 startPoolEvents[DSPerformanceCounters::numEvents];
+    juce::int64 startTicks;
+};
+
+struct BenchmarkScenario {
+    int numZones = 0;
+    int numGroups = 0;
+};
+
+// The converter reports every sample it copies on stdout, which would bury the report
+class ScopedSilencedStandardOutput {
+public:
+    ScopedSilencedStandardOutput() : previous(std::cout.rdbuf(nullptr)) {}
+    ~ScopedSilencedStandardOutput() {
+        std::cout.rdbuf(previous);
+        std::cout.clear();
+    }
+private:
+    std::streambuf *previous;
+};
+
+static bool parseScenario(const std::string &text, BenchmarkScenario &scenario) {
+    juce::String value (text);
+    if(!value.containsChar(':')) {
+        return false;
+    }
+    scenario.numZones = value.upToFirstOccurrenceOf(":", false, false).getIntValue();
+    scenario.numGroups = value.fromFirstOccurrenceOf(":", false, false).getIntValue();
+    return scenario.numZones > 0 && scenario.numGroups > 0;
+}
+
+static double getMedian(juce::Array<double> values) {
+    std::sort(values.begin(), values.end());
+    int middle = values.size() / 2;
+    return (values.size() % 2 == 1) ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+}
+
+static juce::var summarize(juce::Array<double> timings) {
+    std::sort(timings.begin(), timings.end());
+    double total = 0.0;
+    for (double timing : timings) {
+        total += timing;
+    }
+    double median = getMedian(timings);
+    
+    auto *summary = new juce::DynamicObject();
+    summary->setProperty("min", timings.getFirst());
+    summary->setProperty("median", median);
+    summary->setProperty("mean", total / timings.size());
+    summary->setProperty("max", timings.getLast());
+    return juce::var(summary);
+}
+
+// Runs the whole pipeline once, measuring each stage into stages[stage]
+static bool runPipeline(DSConversionScheduler &scheduler, const DSPerformanceCounters &counters, const juce::File &exsFile, const juce::File &outputDirectory, StageSamples *stages) {
+    juce::String name = exsFile.getFileNameWithoutExtension();
+    ScopedSilencedStandardOutput silence;
+    
+    DSEXS24 exs;
+    bool ok;
+    {
+        ScopedStageMeasurement measurement(stages[0], counters);
+        ok = exs.loadExs(exsFile);
+    }
+    if(!ok) {
+        std::cerr << "Unable to load \"" << exsFile.getFullPathName() << "\"." << std::endl;
+        return false;
+    }
+    
+    DSPresetConverter converter;
+    converter.setScheduler(&scheduler);
+    {
+        ScopedStageMeasurement measurement(stages[1], counters);
+        converter.parseDSEXS24(exs);
+    }
+    
+    DSFileSampleResolver resolver(exsFile.getParentDirectory());
+    {
+        ScopedStageMeasurement measurement(stages[2], counters);
+        ok = converter.huntForSamples(resolver, name);
+    }
+    if(!ok) {
+        std::cerr << "Not every sample of \"" << exsFile.getFullPathName() << "\" was found." << std::endl;
+        return false;
+    }
+    
+    {
+        ScopedStageMeasurement measurement(stages[3], counters);
+        ok = converter.convertEXSLoopCrossfadePoints();
+    }
+    if(!ok) {
+        return false;
+    }
+    
+    {
+        ScopedStageMeasurement measurement(stages[4], counters);
+        ok = converter.copySamplesOverToNewDirectory(outputDirectory, name, false, 0);
+    }
+    if(!ok) {
+        return false;
+    }
+    
+    juce::String sfz;
+    {
+        ScopedStageMeasurement measurement(stages[5], counters);
+        sfz = converter.getSFZ();
+    }
+    return sfz.isNotEmpty();
+}
+
+// The median of each counter per stage, also divided by the number of zones and by the
+// megabytes of audio in the instrument's samples
+static juce::var summarizeCounters(const StageSamples *stages, int numZones, double audioMegabytes) {
+    auto *counters = new juce::DynamicObject();
+    for (int stage = 0; stage < numStages; stage++) {
+        auto *stageObject = new juce::DynamicObject();
+        counters->setProperty(stageNames[stage], juce::var(stageObject));
+        for (int event = 0; event < DSPerformanceCounters::numEvents; event++) {
+            if(stages[stage].events[event].isEmpty()) {
+                continue;
+            }
+            double median = getMedian(stages[stage].events[event]);
+            auto *eventObject = new juce::DynamicObject();
+            eventObject->setProperty("median", median);
+            eventObject->setProperty("perZone", median / numZones);
+            eventObject->setProperty("perMB", audioMegabytes > 0.0 ? median / audioMegabytes : 0.0);
+            stageObject->setProperty(DSPerformanceCounters::getEventName((DSPerformanceCounters::Event) event), juce::var(eventObject));
+        }
+    }
+    return juce::var(counters);
+}
+
+// Compares the instructions per zone of every stage with a report from an earlier run,
+// matching scenarios by name. Returns the stages that regressed by more than maxRegression
+// (a fraction), after printing them.
+// numCompared is set to the number of stages found in both reports, so that a baseline
+// that matches nothing isn't mistaken for a pass
+static juce::Array<juce::var> findRegressions(const juce::var &baseline, const juce::Array<juce::var> &scenarioResults, double maxRegression, int &numCompared) {
+    juce::Array<juce::var> regressions;
+    numCompared = 0;
+    const juce::Array<juce::var> *baselineScenarios = baseline.getProperty("scenarios", juce::var()).getArray();
+    if(baselineScenarios == nullptr) {
+        return regressions;
+    }
+    for (auto &result : scenarioResults) {
+        juce::String name = result.getProperty("name", juce::var()).toString();
+        for (auto &baselineResult : *baselineScenarios) {
+            if(baselineResult.getProperty("name", juce::var()).toString() != name) {
+                continue;
+            }
+            for (int stage = 0; stage < numStages; stage++) {
+                juce::var before = baselineResult.getProperty("counters", juce::var()).getProperty(stageNames[stage], juce::var()).getProperty("instructions", juce::var()).getProperty("perZone", juce::var());
+                juce::var after = result.getProperty("counters", juce::var()).getProperty(stageNames[stage], juce::var()).getProperty("instructions", juce::var()).getProperty("perZone", juce::var());
+                if(before.isVoid() || after.isVoid() || (double) before <= 0.0) {
+                    continue;
+                }
+                numCompared++;
+                double change = (double) after / (double) before - 1.0;
+                if(change <= maxRegression) {
+                    continue;
+                }
+                std::cerr << name << ", " << stageNames[stage] << ": " << (double) before << " -> " << (double) after << " instructions per zone (+" << juce::roundToInt(change * 100.0) << "%)." << std::endl;
+                auto *regression = new juce::DynamicObject();
+                regression->setProperty("scenario", name);
+                regression->setProperty("stage", stageNames[stage]);
+                regression->setProperty("baselineInstructionsPerZone", before);
+                regression->setProperty("instructionsPerZone", after);
+                regression->setProperty("change", change);
+                regressions.add(juce::var(regression));
+            }
+        }
+    }
+    return regressions;
+}
+
+int main (int argc, char* argv[])
+{
+    try {
+        TCLAP::CmdLine cmd("Benchmarks the EXS conversion pipeline on synthetic instruments and prints the timings as JSON.", ' ', "0.1");
+        
+        TCLAP::MultiArg<std::string> scenarioArg( "s", "scenario", "An instrument size to benchmark, as <zones>:<groups>. Can be given several times. Defaults to 100:1, 1000:10, 10000:200 and 50000:2000.", false, "zones:groups" );
+        cmd.add( scenarioArg );
+        
+        TCLAP::ValueArg<int> samplesArg( "", "samples", "The most distinct sample files per instrument; zones beyond this share samples. Defaults to 1000.", false, 1000, "count" );
+        cmd.add( samplesArg );
+        
+        TCLAP::ValueArg<int> framesArg( "", "sample-frames", "The length of every sample, in frames. Defaults to 8192.", false, 8192, "frames" );
+        cmd.add( framesArg );
+        
+        TCLAP::ValueArg<int> roundRobinArg( "", "round-robin", "Chain the groups into round robins of this length. Defaults to 1 (none).", false, 1, "length" );
+        cmd.add( roundRobinArg );
+        
+        TCLAP::SwitchArg bigEndianArg( "", "big-endian", "Write the instruments in the big-endian (SOBT) layout instead of little-endian (TBOS).", false );
+        cmd.add( bigEndianArg );
+        
+        std::vector<int> sampleChunkSizes { 336, 592, 600, 1624 };
+        TCLAP::ValuesConstraint<int> sampleChunkSizeConstraint( sampleChunkSizes );
+        TCLAP::ValueArg<int> sampleChunkSizeArg( "", "sample-chunk-size", "The size of the sample chunks in the generated instruments. Defaults to 592.", false, 592, &sampleChunkSizeConstraint );
+        cmd.add( sampleChunkSizeArg );
+        
+        TCLAP::ValueArg<int> repetitionsArg( "r", "repetitions", "How many times to run each scenario. Defaults to 3.", false, 3, "count" );
+        cmd.add( repetitionsArg );
+        
+        TCLAP::ValueArg<int> ioThreadsArg( "", "io-threads", "The number of I/O threads. Defaults to " + std::to_string(DSConversionScheduler::getDefaultIOThreadCount()) + ".", false, 0, "count" );
+        cmd.add( ioThreadsArg );
+        
+        TCLAP::ValueArg<int> cpuThreadsArg( "", "cpu-threads", "The number of CPU threads. Defaults to the number of CPU cores.", false, 0, "count" );
+        cmd.add( cpuThreadsArg );
+        
+        TCLAP::ValueArg<std::string> workDirectoryArg( "", "work-directory", "Where the instruments and converted output are written. Defaults to a new folder in the temporary directory.", false, "", "directory" );
+        cmd.add( workDirectoryArg );
+        
+        TCLAP::SwitchArg keepArg( "", "keep", "Leave the generated instruments in the work directory afterwards.", false );
+        cmd.add( keepArg );
+        
+        TCLAP::ValueArg<std::string> baselineArg( "", "baseline", "A report from an earlier run to compare with. The run fails if any stage of a scenario in both reports now takes more instructions per zone than --max-regression allows. Needs hardware performance counters.", false, "", "json-file" );
+        cmd.add( baselineArg );
+        
+        TCLAP::ValueArg<double> maxRegressionArg( "", "max-regression", "How many percent more instructions per zone a stage may take than in the baseline. Defaults to 2.", false, 2.0, "percent" );
+        cmd.add( maxRegressionArg );
+        
+        TCLAP::ValueArg<std::string> outputArg( "o", "output", "Write the JSON report to this file instead of stdout.", false, "", "json-file" );
+        cmd.add( outputArg );
+        
+        cmd.parse( argc, argv );
+        
+        juce::Array<BenchmarkScenario> scenarios;
+        for (auto &text : scenarioArg.getValue()) {
+            BenchmarkScenario scenario;
+            if(!parseScenario(text, scenario)) {
+                std::cerr << "error: \"" << text << "\" is not a <zones>:<groups> scenario." << std::endl;
+                return 2;
+            }
+            scenarios.add(scenario);
+        }
+        if(scenarios.isEmpty()) {
+            scenarios.add({ 100, 1 });
+            scenarios.add({ 1000, 10 });
+            scenarios.add({ 10000, 200 });
+            scenarios.add({ 50000, 2000 });
+        }
+        int repetitions = juce::jmax(1, repetitionsArg.getValue());
+        
+        juce::File workDirectory = workDirectoryArg.isSet()
+            ? juce::File::getCurrentWorkingDirectory().getChildFile(workDirectoryArg.getValue())
+            : juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("EXS2DSBenchmark", "", false);
+        if(!workDirectory.createDirectory().wasOk()) {
+            std::cerr << "error: unable to create \"" << workDirectory.getFullPathName() << "\"." << std::endl;
+            return 2;
+        }
+        
+        juce::var baseline;
+        if(baselineArg.isSet()) {
+            juce::File baselineFile = juce::File::getCurrentWorkingDirectory().getChildFile(baselineArg.getValue());
+            baseline = juce::JSON::parse(baselineFile.loadFileAsString());
+            if(!baseline.isObject()) {
+                std::cerr << "error: \"" << baselineFile.getFullPathName() << "\" is not a benchmark report." << std::endl;
+                return 2;
+            }
+        }
+        
+        DSPerformanceCounters counters;
+        if(!counters.open()) {
+            std::cerr << "Hardware performance counters are unavailable (" << counters.getError() << "); only times are reported." << std::endl;
+            if(baselineArg.isSet()) {
+                std::cerr << "error: comparing with --baseline needs hardware performance counters." << std::endl;
+                return 2;
+            }
+        }
+        
+        DSConversionScheduler scheduler(ioThreadsArg.getValue(), cpuThreadsArg.getValue());
+        // Counters don't pass a live thread's counts on to its parent, so every pool thread
+        // opens its own
+        scheduler.setThreadStartCallback([&counters] { counters.addCurrentThread(); });
+        
+        juce::Array<juce::var> scenarioResults;
+        bool failed = false;
+        for (auto &scenario : scenarios) {
+            DSSyntheticInstrumentSpec spec;
+            spec.numZones = scenario.numZones;
+            spec.numGroups = scenario.numGroups;
+            spec.numSamples = juce::jmin(scenario.numZones, juce::jmax(1, samplesArg.getValue()));
+            spec.sampleFrames = framesArg.getValue();
+            spec.roundRobinLength = roundRobinArg.getValue();
+            spec.bigEndian = bigEndianArg.getValue();
+            spec.sampleChunkSize = sampleChunkSizeArg.getValue();
+            
+            juce::String name = juce::String(scenario.numZones) + " zones " + juce::String(scenario.numGroups) + " groups";
+            std::cerr << "Generating " << name << "..." << std::endl;
+            juce::File exsFile;
+            if(!DSSyntheticInstrument::write(spec, workDirectory, name, exsFile)) {
+                failed = true;
+                break;
+            }
+            
+            StageSamples stages[numStages];
+            DSInstrumentation::reset();
+            DSAllocationTracker::reset();
+            juce::File outputDirectory = workDirectory.getChildFile(name + " Output");
+            for (int repetition = 0; repetition < repetitions && !failed; repetition++) {
+                std::cerr << "Converting " << name << " (" << (repetition + 1) << "/" << repetitions << ")..." << std::endl;
+                outputDirectory.deleteRecursively();
+                outputDirectory.createDirectory();
+                failed = !runPipeline(scheduler, counters, exsFile, outputDirectory, stages);
+            }
+            outputDirectory.deleteRecursively();
+            if(failed) {
+                break;
+            }
+            
+            // Every copy task opens and writes a file on the pools, which takes far more than
+            // this many user-space instructions. Fewer means the pool threads aren't counted,
+            // and the instruction counts would miss the stages that matter most.
+            const double minPoolInstructionsPerZone = 1000.0;
+            if(counters.isOpen() && getMedian(stages[4].poolInstructions) < minPoolInstructionsPerZone * spec.numZones) {
+                std::cerr << "error: " << stageNames[4] << " counted only " << getMedian(stages[4].poolInstructions) << " instructions on the pool threads for " << spec.numZones << " zones, so the pool threads aren't being counted." << std::endl;
+                failed = true;
+                break;
+            }
+            
+            auto *stageTimes = new juce::DynamicObject();
+            for (int stage = 0; stage < numStages; stage++) {
+                stageTimes->setProperty(stageNames[stage], summarize(stages[stage].seconds));
+            }
+            double audioMegabytes = (double) spec.numSamples * spec.sampleFrames * spec.numChannels * (spec.bitsPerSample / 8) / (1024.0 * 1024.0);
+            auto *result = new juce::DynamicObject();
+            result->setProperty("name", name);
+            result->setProperty("zones", spec.numZones);
+            result->setProperty("groups", spec.numGroups);
+            result->setProperty("samples", spec.numSamples);
+            result->setProperty("sampleFrames", spec.sampleFrames);
+            result->setProperty("exsBytes", exsFile.getSize());
+            result->setProperty("repetitions", repetitions);
+            result->setProperty("audioMegabytes", audioMegabytes);
+            result->setProperty("stages", juce::var(stageTimes));
+            if(counters.isOpen()) {
+                result->setProperty("counters", summarizeCounters(stages, spec.numZones, audioMegabytes));
+            }
+            DSInstrumentation::addToJSON(*result);
+            DSAllocationTracker::addToJSON(*result);
+            scenarioResults.add(juce::var(result));
+        }
+        
+        if(!keepArg.getValue()) {
+            workDirectory.deleteRecursively();
+        }
+        if(failed) {
+            return 4;
+        }
+        
+        auto *report = new juce::DynamicObject();
+        report->setProperty("juceVersion", juce::SystemStats::getJUCEVersion());
+        report->setProperty("operatingSystem", juce::SystemStats::getOperatingSystemName());
+        report->setProperty("cpuCores", juce::SystemStats::getNumCpus());
+        report->setProperty("ioThreads", scheduler.getNumIOThreads());
+        report->setProperty("cpuThreads", scheduler.getNumCPUThreads());
+        report->setProperty("byteOrder", bigEndianArg.getValue() ? "big" : "little");
+        report->setProperty("sampleChunkSize", sampleChunkSizeArg.getValue());
+        report->setProperty("roundRobinLength", roundRobinArg.getValue());
+        report->setProperty("performanceCounters", counters.isOpen());
+        report->setProperty("scenarios", scenarioResults);
+        
+        juce::Array<juce::var> regressions;
+        int numCompared = 0;
+        if(baselineArg.isSet()) {
+            regressions = findRegressions(baseline, scenarioResults, maxRegressionArg.getValue() / 100.0, numCompared);
+            report->setProperty("regressions", regressions);
+            report->setProperty("stagesCompared", numCompared);
+        }
+        
+        juce::String json = juce::JSON::toString(juce::var(report));
+        if(outputArg.isSet()) {
+            juce::File outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(outputArg.getValue());
+            if(!outputFile.replaceWithText(json + "\n")) {
+                std::cerr << "error: unable to write \"" << outputFile.getFullPathName() << "\"." << std::endl;
+                return 2;
+            }
+        } else {
+            std::cout << json << std::endl;
+        }
+        if(!regressions.isEmpty()) {
+            std::cerr << "error: " << regressions.size() << " stage(s) regressed against the baseline." << std::endl;
+            return 5;
+        }
+        if(baselineArg.isSet() && numCompared == 0) {
+            std::cerr << "error: no scenario and stage in the baseline matched this run, so nothing was compared. Run with the same --scenario values, on a machine with performance counters." << std::endl;
+            return 2;
+        }
+        
+    } catch (TCLAP::ArgException &e)  // catch exceptions
+    { std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl; }
+    
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    DSAllocationTracker.cpp
+    Created: 19 Oct 2026 3:07:15am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSAllocationTracker.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#if DS_ENABLE_ALLOCATION_TRACKING
+
+namespace {
+    // Plain atomics in static storage, so they're usable before any constructor has run:
+    // operator new is called during static initialisation.
+    struct StageCounters {
+        std::atomic<juce::int64> count;
+        std::atomic<juce::int64> bytes;
+        std::atomic<juce::int64> liveBytes;
+        std::atomic<juce::int64> peakLiveBytes;
+    };
+
+    // One per DSConversionStats stage, and a last one for allocations made outside of any
+    const int otherStage = DSConversionStats::numStages;
+    StageCounters stageCounters[DSConversionStats::numStages + 1];
+
+    // Keeps the memory handed out aligned as malloc's would be
+    struct alignas (std::max_align_t) AllocationHeader {
+        size_t size;
+        int stage;
+    };
+
+    void *trackedAllocate(size_t size) {
+        // Adding the header mustn't wrap around into a small allocation
+        if(size > SIZE_MAX - sizeof(AllocationHeader)) {
+            return nullptr;
+        }
+        auto *header = static_cast<AllocationHeader *>(std::malloc(sizeof(AllocationHeader) + size));
+        if(header == nullptr) {
+            return nullptr;
+        }
+        int stage = (int) DSConversionStats::getCurrentContext().stage;
+        if(stage < 0 || stage >= DSConversionStats::numStages) {
+            stage = otherStage;
+        }
+        header->size = size;
+        header->stage = stage;
+
+        StageCounters &counters = stageCounters[stage];
+        counters.count.fetch_add(1, std::memory_order_relaxed);
+        counters.bytes.fetch_add((juce::int64) size, std::memory_order_relaxed);
+        juce::int64 live = counters.liveBytes.fetch_add((juce::int64) size, std::memory_order_relaxed) + (juce::int64) size;
+        juce::int64 peak = counters.peakLiveBytes.load(std::memory_order_relaxed);
+        while (live > peak && !counters.peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+        return header + 1;
+    }
+
+    void trackedFree(void *pointer) {
+        if(pointer == nullptr) {
+            return;
+        }
+        auto *header = static_cast<AllocationHeader *>(pointer) - 1;
+        stageCounters[header->stage].liveBytes.fetch_sub((juce::int64) header->size, std::memory_order_relaxed);
+        std::free(header);
+    }
+
+    void *trackedAllocateOrThrow(size_t size) {
+        if(size > SIZE_MAX - sizeof(AllocationHeader)) {
+            throw std::bad_alloc();
+        }
+        for (;;) {
+            if(void *pointer = trackedAllocate(size)) {
+                return pointer;
+            }
+            std::new_handler handler = std::get_new_handler();
+            if(handler == nullptr) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+}
+
+// Only the plain forms are replaced. The over-aligned forms keep the standard library's
+// implementation, which allocates and frees separately from these.
+void *operator new(size_t size) { return trackedAllocateOrThrow(size); }
+void *operator new[](size_t size) { return trackedAllocateOrThrow(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return trackedAllocate(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return trackedAllocate(size); }
+void operator delete(void *pointer) noexcept { trackedFree(pointer); }
+void operator delete[](void *pointer) noexcept { trackedFree(pointer); }
+void operator delete(void *pointer, size_t) noexcept { trackedFree(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { trackedFree(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { trackedFree(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { trackedFree(pointer); }
+
+void DSAllocationTracker::addToJSON(juce::DynamicObject &report) {
+    // Read everything before building the report, which allocates itself
+    juce::int64 values[otherStage + 1][4];
+    for (int stage = 0; stage <= otherStage; stage++) {
+        values[stage][0] = stageCounters[stage].count.load();
+        values[stage][1] = stageCounters[stage].bytes.load();
+        values[stage][2] = stageCounters[stage].peakLiveBytes.load();
+        values[stage][3] = stageCounters[stage].liveBytes.load();
+    }
+
+    auto *allocations = new juce::DynamicObject();
+    report.setProperty("allocations", juce::var(allocations));
+    for (int stage = 0; stage <= otherStage; stage++) {
+        auto *stageObject = new juce::DynamicObject();
+        allocations->setProperty(stage == otherStage ? "other" : DSConversionStats::getStageName((DSConversionStats::Stage) stage), juce::var(stageObject));
+        stageObject->setProperty("count", values[stage][0]);
+        stageObject->setProperty("bytes", values[stage][1]);
+        stageObject->setProperty("peakLiveBytes", values[stage][2]);
+        stageObject->setProperty("liveBytes", values[stage][3]);
+    }
+}
+
+void DSAllocationTracker::reset() {
+    for (auto &counters : stageCounters) {
+        counters.count = 0;
+        counters.bytes = 0;
+        counters.peakLiveBytes = counters.liveBytes.load();
+    }
+}
+
+#else
+
+void DSAllocationTracker::addToJSON(juce::DynamicObject &) {
+}
+
+void DSAllocationTracker::reset() {
+}
+
+#endif
@@ -0,0 +1,39 @@
+/*
+  ==============================================================================
+
+    DSAllocationTracker.h
+    Created: 19 Oct 2026 3:07:15am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DSConversionStats.h"
+
+// Set DS_ENABLE_ALLOCATION_TRACKING=1 in the project's preprocessor definitions to replace
+// the global operator new and delete with versions that count every heap allocation against
+// the pipeline stage the allocating thread is working on. Without it, nothing is replaced.
+#ifndef DS_ENABLE_ALLOCATION_TRACKING
+ #define DS_ENABLE_ALLOCATION_TRACKING 0
+#endif
+
+// Heap traffic per conversion stage: how many allocations each stage made, how many bytes
+// they asked for, and the most bytes the stage's allocations held at any one time. Memory
+// freed in a later stage still counts against the stage that allocated it, so a stage that
+// builds a large value tree for the next one shows up as such.
+//
+// The stage is the calling thread's DSConversionStats stage, which is tracked whether or not
+// any stats are being kept; allocations made outside of one count as "other". Each tracked
+// allocation carries a small header holding its size and stage.
+class DSAllocationTracker {
+public:
+    static constexpr bool isEnabled() { return DS_ENABLE_ALLOCATION_TRACKING != 0; }
+
+    // Adds "allocations": {"<stage>": {"count", "bytes", "peakLiveBytes", "liveBytes"}} to a
+    // report. Does nothing unless tracking is built in.
+    static void addToJSON(juce::DynamicObject &report);
+    // Zeroes the counts and restarts the peaks from the bytes live now
+    static void reset();
+};
@@ -0,0 +1,529 @@
+/*
+  ==============================================================================
+
+    DSBatchConverter.cpp
+    Created: 18 Oct 2026 2:31:05pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSBatchConverter.h"
+#include "DSSFZParser.h"
+#include "DSInstrumentation.h"
+#include "DSAllocationTracker.h"
+
+// Every zone costs something to parse, probe and emit even when its sample is tiny
+static const juce::int64 estimatedBytesPerZone = 64 * 1024;
+
+DSBatchConverter::DSBatchConverter(DSConversionScheduler &scheduler_, int numConcurrentJobs_)
+    : scheduler(scheduler_),
+      numConcurrentJobs(numConcurrentJobs_ > 0 ? numConcurrentJobs_ : scheduler_.getNumCPUThreads()) {
+}
+
+bool DSBatchConverter::addJobsFromListFile(juce::File listFile, bool copySamples, juce::File archiveFile) {
+    if(!listFile.existsAsFile()) {
+        std::cerr << "\"" << listFile.getFullPathName() << "\" is not a file." << std::endl;
+        return false;
+    }
+    
+    juce::StringArray lines = juce::StringArray::fromLines(listFile.loadFileAsString());
+    for (auto line : lines) {
+        line = line.trim();
+        if(line.isEmpty() || line.startsWith("#")) {
+            continue;
+        }
+        
+        juce::StringArray fields = juce::StringArray::fromTokens(line, "\t", "\"");
+        if(fields.size() < 2) {
+            std::cerr << "Skipping batch line \"" << line << "\": expected <exs-file> <TAB> <sfz-file>." << std::endl;
+            continue;
+        }
+        
+        DSConversionJob job;
+        if(archiveFile != juce::File()) {
+            job.archiveFile = archiveFile;
+            job.inputFile = archiveFile.getChildFile(fields[0].trim().unquoted());
+        } else {
+            job.inputFile = juce::File::getCurrentWorkingDirectory().getChildFile(fields[0].trim().unquoted());
+        }
+        juce::StringArray outputPaths = juce::StringArray::fromTokens(fields[1], "|", "\"");
+        outputPaths.trim();
+        outputPaths.removeEmptyStrings();
+        for (auto outputPath : outputPaths) {
+            juce::File outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(outputPath.unquoted());
+            if(job.outputFile == juce::File()) {
+                job.outputFile = outputFile;
+            } else {
+                job.additionalOutputFiles.add(outputFile);
+            }
+        }
+        if(fields.size() > 2) {
+            job.sampleDirectory = fields[2].trim().unquoted();
+        }
+        job.copySamples = copySamples;
+        addJob(job);
+    }
+    return true;
+}
+
+juce::int64 DSBatchConverter::estimateCost(int numZones, juce::int64 totalSampleBytes) {
+    return totalSampleBytes + (juce::int64) numZones * estimatedBytesPerZone;
+}
+
+int DSBatchConverter::run() {
+    const juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+    numAborted = 0;
+    juce::OwnedArray<PreparedJob> preparedJobs;
+    for (auto &job : jobs) {
+        auto *preparedJob = preparedJobs.add(new PreparedJob());
+        preparedJob->job = job;
+    }
+    if(metricsFile != nullptr) {
+        metricsFile->addPendingInstruments(preparedJobs.size());
+    }
+    
+    // The job pool only runs whole instruments; their I/O and CPU work still goes through
+    // the scheduler's pools, which is why the two must not be shared (a job waiting on
+    // its own tasks would otherwise be able to starve them).
+    juce::ThreadPool jobPool(numConcurrentJobs);
+    
+    // Parse and hunt everything first so that the cost of every instrument is known. The
+    // parsed instruments are let go of straight away; keeping a whole batch of them until
+    // they're rendered would take more memory than rendering them.
+    runOnJobPool(jobPool, juce::Array<PreparedJob *>(preparedJobs.begin(), preparedJobs.size()), [this](PreparedJob &preparedJob) {
+        preparedJob.prepared = prepareJob(preparedJob);
+        preparedJob.converter.reset();
+        preparedJob.sampleResolver.reset();
+        if(!preparedJob.prepared) {
+            reportStats(preparedJob, false);
+        }
+    });
+    
+    // Longest processing time first
+    juce::Array<PreparedJob *> order;
+    for (auto *preparedJob : preparedJobs) {
+        if(preparedJob->prepared) {
+            order.add(preparedJob);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [](const PreparedJob *a, const PreparedJob *b) {
+        return a->estimatedCost > b->estimatedCost;
+    });
+    
+    runOnJobPool(jobPool, order, [this](PreparedJob &preparedJob) {
+        preparedJob.succeeded = prepareJob(preparedJob) && finishJob(preparedJob);
+        preparedJob.converter.reset();
+        preparedJob.sampleResolver.reset();
+        reportStats(preparedJob, preparedJob.succeeded);
+    });
+    
+    int numFailed = 0;
+    for (auto *preparedJob : preparedJobs) {
+        if(!preparedJob->succeeded) {
+            std::cerr << "Conversion of \"" << preparedJob->job.inputFile.getFullPathName() << "\" failed." << std::endl;
+            numFailed++;
+        }
+    }
+    
+    if(statsOutput != nullptr) {
+        auto *report = new juce::DynamicObject();
+        juce::var reportVar(report);
+        report->setProperty("type", "run");
+        report->setProperty("instruments", preparedJobs.size());
+        report->setProperty("failed", numFailed);
+        report->setProperty("aborted", numAborted.load());
+        report->setProperty("peakRSSBytes", DSMemoryMonitor::getPeakRSSBytes());
+        report->setProperty("wallSeconds", juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks));
+        runStats.addToJSON(*report);
+        DSInstrumentation::addToJSON(*report);
+        DSAllocationTracker::addToJSON(*report);
+        writeStatsLine(reportVar);
+    }
+    return numFailed;
+}
+
+void DSBatchConverter::runOnJobPool(juce::ThreadPool &jobPool, const juce::Array<PreparedJob *> &preparedJobs, std::function<void(PreparedJob &)> function) {
+    if(preparedJobs.isEmpty()) {
+        return;
+    }
+    std::atomic<int> numUnfinished { preparedJobs.size() };
+    juce::WaitableEvent allFinished;
+    for (auto *preparedJob : preparedJobs) {
+        jobPool.addJob([preparedJob, &function, &numUnfinished, &allFinished] {
+            DSTrace::setCurrentThreadName("Instrument");
+            function(*preparedJob);
+            // The last job to finish wakes the caller, which may return straight away
+            if(--numUnfinished == 0) {
+                allFinished.signal();
+            }
+        });
+    }
+    allFinished.wait();
+}
+
+bool DSBatchConverter::convert(const DSConversionJob &job) {
+    PreparedJob preparedJob;
+    preparedJob.job = job;
+    if(metricsFile != nullptr) {
+        metricsFile->addPendingInstruments(1);
+    }
+    bool succeeded = prepareJob(preparedJob) && finishJob(preparedJob);
+    reportStats(preparedJob, succeeded);
+    return succeeded;
+}
+
+bool DSBatchConverter::convert(const DSConversionJob &job, const DSParsedInstrument &parsed, juce::Array<juce::File> *sampleFiles, juce::Array<juce::File> *missingSampleFiles) {
+    PreparedJob preparedJob;
+    preparedJob.job = job;
+    if(metricsFile != nullptr) {
+        metricsFile->addPendingInstruments(1);
+    }
+    bool prepared = prepareJob(preparedJob, parsed);
+    if(missingSampleFiles != nullptr) {
+        *missingSampleFiles = preparedJob.missingSampleFiles;
+    }
+    if(!prepared) {
+        reportStats(preparedJob, false);
+        return false;
+    }
+    if(sampleFiles != nullptr) {
+        *sampleFiles = preparedJob.sampleFiles;
+    }
+    bool succeeded = finishJob(preparedJob);
+    reportStats(preparedJob, succeeded);
+    return succeeded;
+}
+
+std::shared_ptr<DSZipArchive> DSBatchConverter::getArchive(const juce::File &archiveFile) {
+    const juce::ScopedLock scopedLock(archiveLock);
+    std::shared_ptr<DSZipArchive> &archive = archives[archiveFile.getFullPathName()];
+    if(archive == nullptr) {
+        archive = std::make_shared<DSZipArchive>(archiveFile);
+    }
+    return archive;
+}
+
+bool DSBatchConverter::parseInput(const DSConversionJob &job, DSParsedInstrument &parsed) {
+    const juce::File &inputFile = job.inputFile;
+    
+    if(job.archiveFile != juce::File()) {
+        std::shared_ptr<DSZipArchive> archive = getArchive(job.archiveFile);
+        juce::MemoryBlock exsData;
+        if(!archive->readEntry(archive->findEntry(archive->getEntryPath(inputFile)), exsData)) {
+            std::cerr << "\"" << inputFile.getFullPathName() << "\" is not in the archive." << std::endl;
+            return false;
+        }
+        // The SFZ parser resolves #include against real directories, so only EXS is read from archives
+        if(inputFile.hasFileExtension("sfz") || !parsed.exs.loadExs(exsData.getData(), exsData.getSize())) {
+            std::cerr << "\"" << inputFile.getFullPathName() << "\" is not an EXS file." << std::endl;
+            return false;
+        }
+        parsed.isSFZ = false;
+        parsed.numZones = parsed.exs.getZones().size();
+        return true;
+    }
+    
+    if(!inputFile.existsAsFile()) {
+        std::cerr << "\"" << inputFile.getFullPathName() << "\" is not a file." << std::endl;
+        return false;
+    }
+    
+    parsed.isSFZ = inputFile.hasFileExtension("sfz");
+    if(parsed.isSFZ) {
+        DSSFZParser parser;
+        bool parsedOk = parser.parse(inputFile, parsed.sfz);
+        parsed.includedFiles = parser.getIncludedFiles();
+        if(!parsedOk) {
+            std::cerr << parser.getLastError() << std::endl;
+            return false;
+        }
+        parsed.numZones = parser.getNumRegions();
+    } else {
+        parsed.exs = DSEXS24();
+        parsed.exs.loadExs(inputFile);
+        parsed.numZones = parsed.exs.getZones().size();
+    }
+    return true;
+}
+
+bool DSBatchConverter::prepareJob(PreparedJob &preparedJob) {
+    DSParsedInstrument parsed;
+    DSMetricsFile::ScopedActivity activity(metricsFile);
+    createStats(preparedJob);
+    DSMemoryMonitor::ScopedConversion watchedConversion(memoryMonitor, preparedJob.stats.get(), preparedJob.job.inputFile.getSize());
+    bool prepared;
+    {
+        DSConversionStats::ScopedStage scopedStage(preparedJob.stats.get(), DSConversionStats::stageLoad);
+        DSTrace::ScopedSpan span("load", preparedJob.job.inputFile);
+        prepared = parseInput(preparedJob.job, parsed);
+    }
+    prepared = prepared && prepareJob(preparedJob, parsed);
+    return !handleAbort(preparedJob) && prepared;
+}
+
+bool DSBatchConverter::prepareJob(PreparedJob &preparedJob, const DSParsedInstrument &parsed) {
+    const DSConversionJob &job = preparedJob.job;
+    if(!checkAdditionalOutputFiles(job)) {
+        return false;
+    }
+    
+    createStats(preparedJob);
+    // A batch prepares every job twice: once to estimate it and once more to render it
+    preparedJob.missingSampleFiles.clear();
+    preparedJob.totalSampleBytes = 0;
+    preparedJob.converter = std::make_unique<DSPresetConverter>();
+    preparedJob.converter->setScheduler(&scheduler);
+    preparedJob.converter->setMetadataCache(metadataCache);
+    preparedJob.converter->setStats(preparedJob.stats.get());
+    preparedJob.sampleSetName = job.sampleDirectory;
+    preparedJob.numZones = parsed.numZones;
+    
+    if(parsed.isSFZ) {
+        preparedJob.converter->parseSFZValueTree(parsed.sfz);
+        // SFZ sample paths are relative to the .sfz file itself
+    } else {
+        preparedJob.converter->parseDSEXS24(parsed.exs);
+        
+        if(preparedJob.sampleSetName.isEmpty()) {
+            preparedJob.sampleSetName = job.inputFile.getFileNameWithoutExtension();
+        }
+    }
+    if(job.archiveFile != juce::File()) {
+        // Archived samples can only be used by copying them out
+        if(!job.copySamples && !isArchiveOutputFile(job.outputFile)) {
+            std::cerr << "\"" << job.inputFile.getFullPathName() << "\" is in an archive, so its samples have to be copied (--copy-samples)." << std::endl;
+            return false;
+        }
+        std::shared_ptr<DSZipArchive> archive = getArchive(job.archiveFile);
+        preparedJob.sampleResolver = std::make_unique<DSZipSampleResolver>(archive, archive->getEntryPath(job.inputFile.getParentDirectory()));
+        preparedJob.converter->setSampleResolver(preparedJob.sampleResolver.get());
+        if(!preparedJob.converter->huntForSamples(*preparedJob.sampleResolver, preparedJob.sampleSetName)) {
+            return false;
+        }
+    } else {
+        DSFileSampleResolver resolver(job.inputFile.getParentDirectory(), directoryIndex);
+        preparedJob.converter->huntForSamples(resolver, preparedJob.sampleSetName);
+        for (auto &path : preparedJob.converter->getMissingSamplePaths()) {
+            preparedJob.missingSampleFiles.addArray(resolver.getCandidateFiles(path, preparedJob.sampleSetName));
+        }
+    }
+    
+    // Each reference renders its own copy of the sample, so shared files count once per use
+    preparedJob.sampleFiles = preparedJob.converter->getSampleFiles();
+    for (auto &sampleFile : preparedJob.sampleFiles) {
+        preparedJob.totalSampleBytes += sampleFile.getSize();
+    }
+    preparedJob.estimatedCost = estimateCost(preparedJob.numZones, preparedJob.totalSampleBytes);
+    return true;
+}
+
+void DSBatchConverter::createStats(PreparedJob &preparedJob) {
+    if((statsOutput != nullptr || memoryMonitor != nullptr || metricsFile != nullptr) && preparedJob.stats == nullptr) {
+        preparedJob.stats = std::make_unique<DSConversionStats>();
+    }
+}
+
+bool DSBatchConverter::finishJob(PreparedJob &preparedJob) {
+    DSMetricsFile::ScopedActivity activity(metricsFile);
+    DSMemoryMonitor::ScopedConversion watchedConversion(memoryMonitor, preparedJob.stats.get(), preparedJob.estimatedCost);
+    bool succeeded = renderAndWriteJob(preparedJob);
+    return !handleAbort(preparedJob) && succeeded;
+}
+
+bool DSBatchConverter::handleAbort(PreparedJob &preparedJob) {
+    if(preparedJob.stats == nullptr || !preparedJob.stats->isAborted()) {
+        return false;
+    }
+    std::cerr << "Conversion of \"" << preparedJob.job.inputFile.getFullPathName() << "\" was aborted: the process went over its memory ceiling of " << (memoryMonitor->getMaxRSSBytes() / (1024 * 1024)) << " MB." << std::endl;
+    numAborted++;
+    // A batch keeps prepared jobs around until they're rendered, so let go of the value tree now
+    preparedJob.converter.reset();
+    preparedJob.sampleResolver.reset();
+    return true;
+}
+
+bool DSBatchConverter::renderAndWriteJob(PreparedJob &preparedJob) {
+    const DSConversionJob &job = preparedJob.job;
+    DSPresetConverter &presetMaker = *preparedJob.converter;
+    DSTrace::ScopedSpan span("convert", job.inputFile);
+    
+    presetMaker.convertEXSLoopCrossfadePoints();
+    if(DSConversionStats::isCurrentConversionAborted()) {
+        return false;
+    }
+    
+    if(isArchiveOutputFile(job.outputFile)) {
+        return writeArchive(preparedJob);
+    }
+    
+    DSConversionStats::ScopedStage renderStage(preparedJob.stats.get(), DSConversionStats::stageRender);
+    if(job.copySamples) {
+        if(!presetMaker.copySamplesOverToNewDirectory(job.outputFile.getParentDirectory(), job.outputFile.getFileNameWithoutExtension(), false, 0)) {
+            return false;
+        }
+    } else if(job.sampleDirectory.isNotEmpty())
+        presetMaker.convertPathsToDesiredDirectory(job.inputFile.getParentDirectory(), preparedJob.sampleSetName);
+    else
+        presetMaker.convertPathsToRelative(job.inputFile.getParentDirectory());
+    
+    if(preparedJob.stats != nullptr && preparedJob.stats->isAborted()) {
+        return false;
+    }
+    
+    // Entered here so that outputs written on other threads count against this stage's wall time
+    DSConversionStats::ScopedStage emitStage(preparedJob.stats.get(), DSConversionStats::stageEmit);
+    juce::Array<juce::File> outputFiles { job.outputFile };
+    outputFiles.addArray(job.additionalOutputFiles);
+    if(outputFiles.size() == 1) {
+        return presetMaker.writeOutputFile(job.outputFile);
+    }
+    
+    // Every target is written from the same finished model, so they can all go at once
+    juce::Array<bool> written;
+    written.insertMultiple(0, false, outputFiles.size());
+    {
+        DSConversionScheduler::TaskGroup outputTasks(scheduler);
+        for (int i = 0; i < outputFiles.size(); i++) {
+            outputTasks.addIOTask([&presetMaker, &outputFiles, &written, i] {
+                written.getReference(i) = presetMaker.writeOutputFile(outputFiles[i]);
+            });
+        }
+        outputTasks.wait();
+    }
+    return !written.contains(false);
+}
+
+bool DSBatchConverter::isArchiveOutputFile(const juce::File &outputFile) {
+    return outputFile.hasFileExtension("dslibrary") || outputFile.hasFileExtension("zip");
+}
+
+// The model's sample paths are relative to the directory the samples are copied beside (the
+// first output file's) or, without copying, to the instrument's own. Another target elsewhere
+// would get broken paths, and two targets that are the same file would be written over each
+// other at once.
+bool DSBatchConverter::checkAdditionalOutputFiles(const DSConversionJob &job) {
+    const bool copiesSamples = job.copySamples || isArchiveOutputFile(job.outputFile);
+    juce::File sampleBaseDirectory = (copiesSamples ? job.outputFile : job.inputFile).getParentDirectory().getLinkedTarget();
+    juce::Array<juce::File> targets { job.outputFile.getLinkedTarget() };
+    for (auto &additionalOutputFile : job.additionalOutputFiles) {
+        juce::File target = additionalOutputFile.getLinkedTarget();
+        if(isArchiveOutputFile(additionalOutputFile)) {
+            std::cerr << "\"" << additionalOutputFile.getFullPathName() << "\": only the first output file can be an archive." << std::endl;
+            return false;
+        }
+        if(targets.contains(target)) {
+            std::cerr << "\"" << additionalOutputFile.getFullPathName() << "\" is given as an output file more than once." << std::endl;
+            return false;
+        }
+        if(additionalOutputFile.getParentDirectory().getLinkedTarget() != sampleBaseDirectory) {
+            std::cerr << "\"" << additionalOutputFile.getFullPathName() << "\": further output files have to be in \"" << sampleBaseDirectory.getFullPathName() << "\", which the sample paths are relative to." << std::endl;
+            return false;
+        }
+        targets.add(target);
+    }
+    return true;
+}
+
+// The preset and its samples are streamed into the archive as they're produced, so there's
+// never a Samples folder on disk to zip up afterwards. A .dslibrary holds a DecentSampler
+// preset and a .zip an SFZ; either way the samples have to be copied in, -c or not.
+// The archive is written beside the target and renamed over it once it's complete, so
+// neither a failed conversion nor a repeated one leaves a broken archive in its place
+bool DSBatchConverter::writeArchive(PreparedJob &preparedJob) {
+    const juce::File &outputFile = preparedJob.job.outputFile;
+    juce::File partialFile = outputFile.getSiblingFile(outputFile.getFileName() + ".partial");
+    partialFile.deleteFile();
+    
+    bool succeeded = writeArchive(preparedJob, partialFile);
+    if(succeeded && !DSSampleIO::replaceFile(partialFile, outputFile)) {
+        std::cerr << "Unable to write \"" << outputFile.getFullPathName() << "\"." << std::endl;
+        succeeded = false;
+    }
+    if(!succeeded) {
+        partialFile.deleteFile();
+    }
+    return succeeded;
+}
+
+bool DSBatchConverter::writeArchive(PreparedJob &preparedJob, const juce::File &archiveFile) {
+    const DSConversionJob &job = preparedJob.job;
+    DSPresetConverter &presetMaker = *preparedJob.converter;
+    
+    std::unique_ptr<juce::FileOutputStream> fileStream = std::make_unique<juce::FileOutputStream>(archiveFile);
+    if(!fileStream->openedOk()) {
+        std::cerr << "Unable to write \"" << job.outputFile.getFullPathName() << "\"." << std::endl;
+        return false;
+    }
+    DSZipWriter archive(std::move(fileStream));
+    
+    presetMaker.setOutputArchive(&archive);
+    bool copied = presetMaker.copySamplesOverToNewDirectory(job.outputFile.getParentDirectory(), job.outputFile.getFileNameWithoutExtension(), false, 0);
+    presetMaker.setOutputArchive(nullptr);
+    if(!copied) {
+        return false;
+    }
+    
+    DSConversionStats::ScopedStage emitStage(preparedJob.stats.get(), DSConversionStats::stageEmit);
+    DSTrace::ScopedSpan span("emit", job.outputFile);
+    const bool isLibrary = job.outputFile.hasFileExtension("dslibrary");
+    juce::MemoryOutputStream presetStream;
+    if(!presetMaker.writeOutput(presetStream, isLibrary ? DSPresetConverter::outputFormatDSPreset : DSPresetConverter::outputFormatSFZ)) {
+        return false;
+    }
+    juce::String presetName = job.outputFile.getFileNameWithoutExtension() + (isLibrary ? ".dspreset" : ".sfz");
+    
+    // Any further targets use the same relative sample paths, so they work beside the unpacked archive
+    juce::Array<bool> written;
+    written.insertMultiple(0, false, job.additionalOutputFiles.size());
+    {
+        DSConversionScheduler::TaskGroup outputTasks(scheduler);
+        for (int i = 0; i < job.additionalOutputFiles.size(); i++) {
+            outputTasks.addIOTask([&presetMaker, &job, &written, i] {
+                written.getReference(i) = presetMaker.writeOutputFile(job.additionalOutputFiles[i]);
+            });
+        }
+        if(!archive.addEntry(presetName, presetStream.getData(), presetStream.getDataSize(), DSZipWriter::compressionDeflated)
+           || !archive.finish()) {
+            std::cerr << "Unable to write \"" << job.outputFile.getFullPathName() << "\"." << std::endl;
+            outputTasks.wait();
+            return false;
+        }
+        outputTasks.wait();
+    }
+    return !written.contains(false);
+}
+
+void DSBatchConverter::reportStats(PreparedJob &preparedJob, bool succeeded) {
+    if(metricsFile != nullptr) {
+        metricsFile->addConversion(preparedJob.stats.get(), succeeded);
+    }
+    if(statsOutput == nullptr || preparedJob.stats == nullptr) {
+        return;
+    }
+    
+    auto *report = new juce::DynamicObject();
+    juce::var reportVar(report);
+    report->setProperty("type", "instrument");
+    report->setProperty("input", preparedJob.job.inputFile.getFullPathName());
+    juce::Array<juce::var> outputs;
+    outputs.add(preparedJob.job.outputFile.getFullPathName());
+    for (auto &outputFile : preparedJob.job.additionalOutputFiles) {
+        outputs.add(outputFile.getFullPathName());
+    }
+    report->setProperty("outputs", outputs);
+    report->setProperty("succeeded", succeeded);
+    report->setProperty("aborted", preparedJob.stats->isAborted());
+    report->setProperty("zones", preparedJob.numZones);
+    preparedJob.stats->addToJSON(*report);
+    
+    writeStatsLine(reportVar);
+    const juce::ScopedLock scopedLock(statsLock);
+    runStats.merge(*preparedJob.stats);
+}
+
+void DSBatchConverter::writeStatsLine(const juce::var &report) {
+    const juce::ScopedLock scopedLock(statsLock);
+    statsOutput->writeText(juce::JSON::toString(report, true) + "\n", false, false, nullptr);
+    statsOutput->flush();
+}
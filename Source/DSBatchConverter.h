@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    DSBatchConverter.h
+    Created: 18 Oct 2026 2:31:05pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DSPresetConverter.h"
+#include "DSZipSampleResolver.h"
+#include "DSMemoryMonitor.h"
+#include "DSMetricsFile.h"
+
+// inputFile can be an EXS instrument or an SFZ file. If archiveFile is set, the instrument
+// and its samples are read from that zip instead, and inputFile is the instrument's
+// virtual path below the archive (e.g. /libraries/Piano.zip/Instruments/Piano.exs).
+struct DSConversionJob {
+    juce::File inputFile;
+    juce::File archiveFile;
+    juce::File outputFile;
+    // Further targets written from the same parsed, hunted and rendered instrument. Samples
+    // are copied next to outputFile; the format of each file follows its extension.
+    juce::Array<juce::File> additionalOutputFiles;
+    juce::String sampleDirectory;
+    bool copySamples = false;
+};
+
+// An instrument's input file after parsing, kept so it can be converted again without
+// being re-read
+struct DSParsedInstrument {
+    bool isSFZ = false;
+    DSEXS24 exs;
+    juce::ValueTree sfz;
+    int numZones = 0;
+    // The files an SFZ #includes, including where missing ones were looked for. Filled in
+    // even when parsing fails.
+    juce::Array<juce::File> includedFiles;
+};
+
+// Converts a list of instruments, several at a time. Every instrument is parsed and its
+// samples hunted up front so that its cost can be estimated, and the instruments are
+// then rendered largest-first (longest-processing-time-first), which keeps one huge
+// instrument from starting last and leaving a long tail on a single core. Only the estimate
+// is kept from the first pass: each instrument is parsed and hunted again when its turn to
+// render comes, so memory grows with the number of jobs running, not with the batch.
+class DSBatchConverter {
+public:
+    // Passing 0 (or less) for numConcurrentJobs runs one instrument per CPU thread of the scheduler.
+    DSBatchConverter(DSConversionScheduler &scheduler, int numConcurrentJobs = 0);
+    
+    // Optional caches shared by every job, for processes that convert many instruments
+    // over their lifetime. Both must outlive the converter.
+    void setDirectoryIndex(DSDirectoryIndex *newDirectoryIndex) { directoryIndex = newDirectoryIndex; }
+    void setMetadataCache(DSSampleMetadataCache *newMetadataCache) { metadataCache = newMetadataCache; }
+    // When set, a JSON object with the per-stage times and counts of each instrument is
+    // written to this stream as a line of its own once the instrument is done, followed by
+    // one for the whole batch at the end of run(). The stream must outlive the converter.
+    void setStatsOutput(juce::OutputStream *newStatsOutput) { statsOutput = newStatsOutput; }
+    // When set, the monitor watches every conversion, recording the peak resident memory of
+    // each stage and aborting conversions that take the process over its ceiling. Must
+    // outlive the converter.
+    void setMemoryMonitor(DSMemoryMonitor *newMemoryMonitor) { memoryMonitor = newMemoryMonitor; }
+    // When set, every instrument is counted in these metrics as it's queued, worked on and
+    // finished. Must outlive the converter.
+    void setMetricsFile(DSMetricsFile *newMetricsFile) { metricsFile = newMetricsFile; }
+    
+    void addJob(const DSConversionJob &job) { jobs.add(job); }
+    int getNumJobs() const { return jobs.size(); }
+    const juce::Array<DSConversionJob> &getJobs() const { return jobs; }
+    int getNumConcurrentJobs() const { return numConcurrentJobs; }
+    
+    // Reads a job list with one instrument per line:
+    //     <exs-file> <TAB> <sfz-file> [<TAB> <sample-directory>]
+    // The <sfz-file> field may list several output files separated by |.
+    // Blank lines and lines starting with # are ignored. Relative paths are resolved
+    // against the current working directory, except that with an archive the instrument
+    // paths are paths inside it.
+    bool addJobsFromListFile(juce::File listFile, bool copySamples, juce::File archiveFile = juce::File());
+    
+    // Runs every job and returns the number that failed.
+    int run();
+    
+    // Converts one instrument on the calling thread, outside the job list. Can be called
+    // from several threads at once.
+    bool convert(const DSConversionJob &job);
+    // The same, starting from an input that has already been parsed. The sample files the
+    // instrument turned out to use are put in sampleFiles, and every place that samples
+    // which couldn't be found were looked for in missingSampleFiles.
+    bool convert(const DSConversionJob &job, const DSParsedInstrument &parsed, juce::Array<juce::File> *sampleFiles = nullptr, juce::Array<juce::File> *missingSampleFiles = nullptr);
+    bool parseInput(const DSConversionJob &job, DSParsedInstrument &parsed);
+    
+    // A rough cost for converting an instrument, in bytes of sample data to process.
+    static juce::int64 estimateCost(int numZones, juce::int64 totalSampleBytes);
+    
+private:
+    struct PreparedJob {
+        DSConversionJob job;
+        std::unique_ptr<DSPresetConverter> converter;
+        std::unique_ptr<DSSampleResolver> sampleResolver;
+        std::unique_ptr<DSConversionStats> stats;
+        juce::String sampleSetName;
+        int numZones = 0;
+        juce::Array<juce::File> sampleFiles;
+        juce::Array<juce::File> missingSampleFiles;
+        juce::int64 totalSampleBytes = 0;
+        juce::int64 estimatedCost = 0;
+        bool prepared = false;
+        bool succeeded = false;
+    };
+    
+    bool prepareJob(PreparedJob &preparedJob);
+    bool prepareJob(PreparedJob &preparedJob, const DSParsedInstrument &parsed);
+    // Runs every job on the job pool and returns once they've all finished
+    void runOnJobPool(juce::ThreadPool &jobPool, const juce::Array<PreparedJob *> &preparedJobs, std::function<void(PreparedJob &)> function);
+    bool finishJob(PreparedJob &preparedJob);
+    // Reports an aborted job and frees everything it holds. Returns false if it wasn't aborted.
+    bool handleAbort(PreparedJob &preparedJob);
+    bool writeArchive(PreparedJob &preparedJob);
+    bool writeArchive(PreparedJob &preparedJob, const juce::File &archiveFile);
+    bool renderAndWriteJob(PreparedJob &preparedJob);
+    void createStats(PreparedJob &preparedJob);
+    // Counts a finished instrument in the metrics and writes its --stats line
+    void reportStats(PreparedJob &preparedJob, bool succeeded);
+    void writeStatsLine(const juce::var &report);
+    static bool isArchiveOutputFile(const juce::File &outputFile);
+    // Rejects further output files that can't be written from the same model as the first
+    static bool checkAdditionalOutputFiles(const DSConversionJob &job);
+    std::shared_ptr<DSZipArchive> getArchive(const juce::File &archiveFile);
+    
+    DSConversionScheduler &scheduler;
+    DSDirectoryIndex *directoryIndex = nullptr;
+    DSSampleMetadataCache *metadataCache = nullptr;
+    int numConcurrentJobs;
+    juce::Array<DSConversionJob> jobs;
+    
+    juce::OutputStream *statsOutput = nullptr;
+    DSMemoryMonitor *memoryMonitor = nullptr;
+    DSMetricsFile *metricsFile = nullptr;
+    std::atomic<int> numAborted { 0 };
+    juce::CriticalSection statsLock;
+    DSConversionStats runStats;
+    
+    // Archives are opened and indexed once, however many instruments they hold
+    juce::CriticalSection archiveLock;
+    std::map<juce::String, std::shared_ptr<DSZipArchive>> archives;
+};
@@ -0,0 +1,279 @@
+/*
+  ==============================================================================
+
+    DSConversionDaemon.cpp
+    Created: 18 Oct 2026 8:31:47pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSConversionDaemon.h"
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <cerrno>
+ #include <cstring>
+ #include <poll.h>
+ #include <sys/socket.h>
+ #include <sys/stat.h>
+ #include <sys/un.h>
+ #include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+ #define MSG_NOSIGNAL 0
+#endif
+
+// A request line longer than this isn't a conversion request
+static const size_t maxRequestLength = 1024 * 1024;
+
+DSConversionDaemon::DSConversionDaemon(DSConversionScheduler &scheduler_, int maxConnections_)
+    : converter(scheduler_),
+      maxConnections(juce::jmax(1, maxConnections_)),
+      connectionPool(maxConnections) {
+    converter.setDirectoryIndex(&directoryIndex);
+    converter.setMetadataCache(&metadataCache);
+}
+
+DSConversionDaemon::~DSConversionDaemon() {
+    stop();
+    connectionPool.removeAllJobs(true, 10000);
+#if JUCE_LINUX || JUCE_MAC
+    for (int fileDescriptor : wakePipe) {
+        if(fileDescriptor >= 0) {
+            close(fileDescriptor);
+        }
+    }
+#endif
+}
+
+bool DSConversionDaemon::isSupported() {
+#if JUCE_LINUX || JUCE_MAC
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if JUCE_LINUX || JUCE_MAC
+
+static bool sendAll(int connection, const char *data, size_t numBytes) {
+    while(numBytes > 0) {
+        ssize_t numSent = send(connection, data, numBytes, MSG_NOSIGNAL);
+        if(numSent <= 0) {
+            return false;
+        }
+        data += numSent;
+        numBytes -= (size_t) numSent;
+    }
+    return true;
+}
+
+bool DSConversionDaemon::run(const juce::File &socketFile) {
+    const std::string path = socketFile.getFullPathName().toStdString();
+    sockaddr_un address {};
+    if(path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "error: socket path \"" << path << "\" is too long." << std::endl;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    
+    // A socket left behind by a daemon that didn't shut down cleanly would make bind fail
+    struct stat status;
+    if(lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+        unlink(path.c_str());
+    }
+    
+    if(pipe(wakePipe) != 0) {
+        std::cerr << "error: could not create a pipe: " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listener < 0
+       || bind(listener, (sockaddr *) &address, sizeof(address)) != 0
+       || listen(listener, 64) != 0) {
+        std::cerr << "error: could not listen on \"" << path << "\": " << strerror(errno) << std::endl;
+        if(listener >= 0) {
+            close(listener);
+        }
+        return false;
+    }
+    std::cout << "Listening on \"" << path << "\"." << std::endl;
+    
+    while(!shouldStop) {
+        pollfd descriptors[2] = { { listener, POLLIN, 0 }, { wakePipe[0], POLLIN, 0 } };
+        if(poll(descriptors, 2, -1) < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if(descriptors[1].revents != 0) {
+            break;
+        }
+        if(descriptors[0].revents == 0) {
+            continue;
+        }
+        
+        int connection = accept(listener, nullptr, nullptr);
+        if(connection < 0) {
+            if(errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+#ifdef SO_NOSIGPIPE
+        int noSigPipe = 1;
+        setsockopt(connection, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+        // Queuing the connection would leave its client waiting without a word until
+        // another one disconnects
+        if(numConnections >= maxConnections) {
+            const std::string response = "{\"ok\": false, \"error\": \"The daemon is already serving " + std::to_string(maxConnections) + " connections.\"}\n";
+            sendAll(connection, response.data(), response.size());
+            close(connection);
+            continue;
+        }
+        numConnections++;
+        connectionPool.addJob([this, connection] {
+            serveConnection(connection);
+            close(connection);
+            numConnections--;
+        });
+    }
+    
+    close(listener);
+    unlink(path.c_str());
+    // Idle connections have been woken by now; this only waits for requests being converted
+    connectionPool.removeAllJobs(false, 60000);
+    return true;
+}
+
+void DSConversionDaemon::serveConnection(int connection) {
+    std::string pending;
+    char buffer[4096];
+    
+    while(!shouldStop) {
+        pollfd descriptors[2] = { { connection, POLLIN, 0 }, { wakePipe[0], POLLIN, 0 } };
+        if(poll(descriptors, 2, -1) < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if(descriptors[1].revents != 0) {
+            return;
+        }
+        
+        ssize_t numRead = recv(connection, buffer, sizeof(buffer), 0);
+        if(numRead <= 0) {
+            return;
+        }
+        pending.append(buffer, (size_t) numRead);
+        
+        size_t lineEnd;
+        while((lineEnd = pending.find('\n')) != std::string::npos) {
+            juce::String line = juce::String::fromUTF8(pending.data(), (int) lineEnd).trim();
+            pending.erase(0, lineEnd + 1);
+            if(line.isEmpty()) {
+                continue;
+            }
+            
+            juce::String response = handleRequest(line) + "\n";
+            if(!sendAll(connection, response.toRawUTF8(), response.getNumBytesAsUTF8())) {
+                return;
+            }
+        }
+        
+        if(pending.size() > maxRequestLength) {
+            return;
+        }
+    }
+}
+
+void DSConversionDaemon::stop() {
+    shouldStop = true;
+    if(wakePipe[1] >= 0) {
+        const char wake = 1;
+        ssize_t numWritten = write(wakePipe[1], &wake, 1);
+        (void) numWritten;
+    }
+}
+
+#else
+
+bool DSConversionDaemon::run(const juce::File &) {
+    std::cerr << "error: the conversion daemon needs Unix domain sockets, which this platform doesn't have." << std::endl;
+    return false;
+}
+
+void DSConversionDaemon::serveConnection(int) {
+}
+
+void DSConversionDaemon::stop() {
+    shouldStop = true;
+}
+
+#endif
+
+juce::String DSConversionDaemon::handleRequest(const juce::String &line) {
+    auto *response = new juce::DynamicObject();
+    juce::var responseVar(response);
+    
+    auto fail = [&response, &responseVar](const juce::String &error) {
+        response->setProperty("ok", false);
+        response->setProperty("error", error);
+        return juce::JSON::toString(responseVar, true);
+    };
+    
+    juce::var request;
+    if(juce::JSON::parse(line, request).failed() || !request.isObject()) {
+        return fail("The request is not a JSON object.");
+    }
+    
+    if(request.getProperty("command", "convert").toString() == "shutdown") {
+        stop();
+        response->setProperty("ok", true);
+        return juce::JSON::toString(responseVar, true);
+    }
+    
+    // juce::File only takes absolute paths, and the daemon's working directory means
+    // nothing to its clients
+    const juce::String inputPath = request.getProperty("input", "").toString();
+    if(!juce::File::isAbsolutePath(inputPath)) {
+        return fail("\"input\" must be an absolute path.");
+    }
+    
+    DSConversionJob job;
+    job.inputFile = juce::File(inputPath);
+    job.sampleDirectory = request.getProperty("sampleDirectory", "").toString();
+    job.copySamples = (bool) request.getProperty("copySamples", false);
+    
+    if(auto *outputs = request.getProperty("outputs", juce::var()).getArray()) {
+        for (auto &output : *outputs) {
+            if(!juce::File::isAbsolutePath(output.toString())) {
+                return fail("Every entry in \"outputs\" must be an absolute path.");
+            }
+            juce::File outputFile(output.toString());
+            if(job.outputFile == juce::File()) {
+                job.outputFile = outputFile;
+            } else {
+                job.additionalOutputFiles.add(outputFile);
+            }
+        }
+    }
+    if(job.outputFile == juce::File()) {
+        return fail("A request needs at least one entry in \"outputs\".");
+    }
+    
+    const double startTime = juce::Time::getMillisecondCounterHiRes();
+    if(!converter.convert(job)) {
+        return fail("Conversion of \"" + job.inputFile.getFullPathName() + "\" failed.");
+    }
+    
+    response->setProperty("ok", true);
+    response->setProperty("milliseconds", juce::Time::getMillisecondCounterHiRes() - startTime);
+    return juce::JSON::toString(responseVar, true);
+}
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    DSConversionDaemon.h
+    Created: 18 Oct 2026 8:31:47pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DSBatchConverter.h"
+
+// Serves conversion requests on a local Unix socket, keeping the thread pools, the
+// directory index and the sample metadata cache warm between requests.
+//
+// Each request is one line of JSON:
+//     {"input": "/path/Piano.exs", "outputs": ["/path/Piano.sfz", "/path/Piano.dspreset"],
+//      "sampleDirectory": "", "copySamples": false}
+// and is answered with one line of JSON:
+//     {"ok": true, "milliseconds": 4.2}
+// or {"ok": false, "error": "..."}. {"command": "shutdown"} stops the daemon.
+// A connection can send any number of requests; up to maxConnections connections are
+// served concurrently, and any more are answered with an error and closed.
+class DSConversionDaemon {
+public:
+    DSConversionDaemon(DSConversionScheduler &scheduler, int maxConnections = 8);
+    ~DSConversionDaemon();
+    
+    static bool isSupported();
+    
+    // Listens on socketFile until a shutdown request arrives. Returns false if the
+    // socket couldn't be set up.
+    bool run(const juce::File &socketFile);
+    
+private:
+    void serveConnection(int connection);
+    juce::String handleRequest(const juce::String &line);
+    // Makes run() return and every connection close once its current request is answered
+    void stop();
+    
+    DSDirectoryIndex directoryIndex;
+    DSSampleMetadataCache metadataCache;
+    DSBatchConverter converter;
+    const int maxConnections;
+    juce::ThreadPool connectionPool;
+    std::atomic<int> numConnections { 0 };
+    std::atomic<bool> shouldStop { false };
+    // Written to by stop(). The read end is never drained, so it stays readable and wakes
+    // the accept loop and every connection polling on it.
+    int wakePipe[2] = { -1, -1 };
+};
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    DSConversionScheduler.cpp
+    Created: 18 Oct 2026 10:12:40am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSConversionScheduler.h"
+
+// The scheduler whose thread start callback has run on this thread
+static thread_local const DSConversionScheduler *threadStartedFor = nullptr;
+
+DSConversionScheduler::DSConversionScheduler(int ioThreads, int cpuThreads, DSSampleIO::Backend ioBackend)
+    : numIOThreads(ioThreads > 0 ? ioThreads : getDefaultIOThreadCount()),
+      numCPUThreads(cpuThreads > 0 ? cpuThreads : getDefaultCPUThreadCount()),
+      ioPool(numIOThreads),
+      cpuPool(numCPUThreads),
+      sampleIO(ioBackend) {
+}
+
+DSConversionScheduler::~DSConversionScheduler() {
+    ioPool.removeAllJobs(false, -1);
+    cpuPool.removeAllJobs(false, -1);
+}
+
+DSConversionScheduler::TaskGroup::TaskGroup(DSConversionScheduler &owner) : scheduler(owner) {
+}
+
+DSConversionScheduler::TaskGroup::~TaskGroup() {
+    wait();
+}
+
+void DSConversionScheduler::TaskGroup::addIOTask(std::function<void()> task) {
+    addTask(scheduler.ioPool, "I/O", std::move(task));
+}
+
+void DSConversionScheduler::TaskGroup::addCPUTask(std::function<void()> task) {
+    addTask(scheduler.cpuPool, "CPU", std::move(task));
+}
+
+void DSConversionScheduler::TaskGroup::addTask(juce::ThreadPool &pool, const char *threadName, std::function<void()> task) {
+    // The count is raised before the job is queued, so a task that chains a
+    // follow-up task never lets the group drop to zero in between.
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        ++pending;
+    }
+    pool.addJob([this, threadName, task = std::move(task), context = DSConversionStats::getCurrentContext()] {
+        if(threadStartedFor != &scheduler) {
+            threadStartedFor = &scheduler;
+            if(scheduler.threadStartCallback != nullptr) {
+                scheduler.threadStartCallback();
+            }
+        }
+        DSTrace::setCurrentThreadName(threadName);
+        {
+            DSConversionStats::ScopedTask scopedTask(context);
+            task();
+        }
+        // Nothing may touch the group once the lock is released: a waiting
+        // thread is free to destroy it as soon as the count reaches zero.
+        std::lock_guard<std::mutex> guard(mutex);
+        --pending;
+        taskFinished.notify_all();
+    });
+}
+
+void DSConversionScheduler::TaskGroup::waitForCapacity(int maxPending) {
+    maxPending = juce::jmax(1, maxPending);
+    std::unique_lock<std::mutex> guard(mutex);
+    taskFinished.wait(guard, [this, maxPending] { return pending < maxPending; });
+}
+
+void DSConversionScheduler::TaskGroup::wait() {
+    std::unique_lock<std::mutex> guard(mutex);
+    taskFinished.wait(guard, [this] { return pending == 0; });
+}
+
+int DSConversionScheduler::TaskGroup::getNumPending() const {
+    std::lock_guard<std::mutex> guard(mutex);
+    return pending;
+}
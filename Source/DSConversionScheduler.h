@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    DSConversionScheduler.h
+    Created: 18 Oct 2026 10:12:40am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <condition_variable>
+#include <mutex>
+#include "DSSampleIO.h"
+#include "DSConversionStats.h"
+#include "DSTrace.h"
+
+// Runs the conversion pipeline's work on two separate thread pools: one for
+// I/O-bound tasks (stat'ing, reading and writing sample files) and one for
+// CPU-bound tasks (decoding, crossfading and encoding). Keeping the limits
+// independent lets a local SSD and an NFS mount be tuned separately.
+class DSConversionScheduler {
+public:
+    // Passing 0 (or less) for either count uses the corresponding default.
+    DSConversionScheduler(int numIOThreads = 0, int numCPUThreads = 0, DSSampleIO::Backend ioBackend = DSSampleIO::backendAuto);
+    ~DSConversionScheduler();
+
+    static int getDefaultIOThreadCount() { return 4; }
+    static int getDefaultCPUThreadCount() { return juce::jmax(1, juce::SystemStats::getNumCpus()); }
+
+    int getNumIOThreads() const { return numIOThreads; }
+    int getNumCPUThreads() const { return numCPUThreads; }
+    
+    // The file I/O used by tasks running on the I/O pool
+    DSSampleIO &getSampleIO() { return sampleIO; }
+    
+    // Tasks queued or running on each pool, for monitoring
+    int getNumIOTasks() const { return ioPool.getNumJobs(); }
+    int getNumCPUTasks() const { return cpuPool.getNumJobs(); }
+    
+    // Called on each pool thread before the first task it runs, e.g. to set up per-thread
+    // performance counters. Set it before adding any tasks.
+    void setThreadStartCallback(std::function<void()> callback) { threadStartCallback = std::move(callback); }
+
+    // A set of tasks that can be waited on together. Tasks may add follow-up
+    // tasks to the same group (e.g. read -> render -> write), and the group
+    // only counts as finished once every chain has run to completion.
+    // Each task runs in the DSConversionStats context of the thread that added it.
+    // The destructor waits for any outstanding tasks.
+    class TaskGroup {
+    public:
+        TaskGroup(DSConversionScheduler &owner);
+        ~TaskGroup();
+
+        void addIOTask(std::function<void()> task);
+        void addCPUTask(std::function<void()> task);
+
+        // Blocks until fewer than maxPending tasks are queued or running.
+        void waitForCapacity(int maxPending);
+        void wait();
+
+        int getNumPending() const;
+    private:
+        void addTask(juce::ThreadPool &pool, const char *threadName, std::function<void()> task);
+
+        DSConversionScheduler &scheduler;
+        // pending is only read or changed with the mutex held, so a waiter can't miss the
+        // notification that goes with a decrement.
+        mutable std::mutex mutex;
+        std::condition_variable taskFinished;
+        int pending = 0;
+
+        JUCE_DECLARE_NON_COPYABLE (TaskGroup)
+    };
+
+private:
+    int numIOThreads;
+    int numCPUThreads;
+    juce::ThreadPool ioPool;
+    juce::ThreadPool cpuPool;
+    DSSampleIO sampleIO;
+    std::function<void()> threadStartCallback;
+
+    JUCE_DECLARE_NON_COPYABLE (DSConversionScheduler)
+};
@@ -0,0 +1,264 @@
+/*
+  ==============================================================================
+
+    DSConversionStats.cpp
+    Created: 18 Oct 2026 11:41:26pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSConversionStats.h"
+#include "DSMemoryMonitor.h"
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <time.h>
+#endif
+
+namespace {
+    // The calling thread's context, and where its clocks stood when time was last charged
+    struct ThreadState {
+        DSConversionStats::Context context;
+        bool recordsWallTime = false;
+        juce::int64 markTicks = 0;
+        juce::int64 markCPUNanoseconds = 0;
+    };
+    
+    thread_local ThreadState threadState;
+}
+
+DSConversionStats::DSConversionStats() {
+    for (int stage = 0; stage < numStages; stage++) {
+        wallTicks[stage] = 0;
+        cpuNanoseconds[stage] = 0;
+        peakRSSBytes[stage] = 0;
+        activeStages[stage] = 0;
+        for (int counter = 0; counter < numCounters; counter++) {
+            counters[stage][counter] = 0;
+        }
+    }
+}
+
+const char *DSConversionStats::getStageName(Stage stage) {
+    switch (stage) {
+        case stageLoad:     return "load";
+        case stageParse:    return "parse";
+        case stageHunt:     return "hunt";
+        case stageProbe:    return "probe";
+        case stageRender:   return "render";
+        case stageEmit:     return "emit";
+        default:            return "";
+    }
+}
+
+const char *DSConversionStats::getCounterName(Counter counter) {
+    switch (counter) {
+        case counterFilesStatted:   return "filesStatted";
+        case counterBytesRead:      return "bytesRead";
+        case counterBytesWritten:   return "bytesWritten";
+        case counterReadersOpened:  return "readersOpened";
+        case counterRegionsEmitted: return "regionsEmitted";
+        case counterSamplesRendered: return "samplesRendered";
+        default:                    return "";
+    }
+}
+
+DSConversionStats::Context DSConversionStats::getCurrentContext() {
+    return threadState.context;
+}
+
+void DSConversionStats::count(Counter counter, juce::int64 amount) {
+    const Context &context = threadState.context;
+    if(context.stats != nullptr) {
+        context.stats->counters[context.stage][counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+}
+
+bool DSConversionStats::isCounting() {
+    return threadState.context.stats != nullptr;
+}
+
+bool DSConversionStats::isCurrentConversionAborted() {
+    const Context &context = threadState.context;
+    return context.stats != nullptr && context.stats->isAborted();
+}
+
+void DSConversionStats::recordRSS(juce::int64 rssBytes) {
+    for (int stage = 0; stage < numStages; stage++) {
+        if(activeStages[stage].load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        juce::int64 peak = peakRSSBytes[stage].load(std::memory_order_relaxed);
+        while (rssBytes > peak && !peakRSSBytes[stage].compare_exchange_weak(peak, rssBytes, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+juce::int64 DSConversionStats::getPeakRSSBytes(Stage stage) const {
+    return peakRSSBytes[stage].load();
+}
+
+juce::int64 DSConversionStats::getThreadCPUNanoseconds() {
+#if JUCE_WINDOWS
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if(!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0;
+    }
+    auto toHundredsOfNanoseconds = [](const FILETIME &time) {
+        return ((juce::int64) time.dwHighDateTime << 32) | (juce::int64) time.dwLowDateTime;
+    };
+    return 100 * (toHundredsOfNanoseconds(kernelTime) + toHundredsOfNanoseconds(userTime));
+#else
+    timespec time;
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+        return 0;
+    }
+    return (juce::int64) time.tv_sec * 1000000000 + time.tv_nsec;
+#endif
+}
+
+// Charges the time since the last mark to the current context and moves the mark up
+void DSConversionStats::chargeElapsedTime() {
+    ThreadState &state = threadState;
+    juce::int64 ticks = juce::Time::getHighResolutionTicks();
+    juce::int64 cpuTime = getThreadCPUNanoseconds();
+    if(state.context.stats != nullptr) {
+        state.context.stats->cpuNanoseconds[state.context.stage].fetch_add(cpuTime - state.markCPUNanoseconds, std::memory_order_relaxed);
+        if(state.recordsWallTime) {
+            state.context.stats->wallTicks[state.context.stage].fetch_add(ticks - state.markTicks, std::memory_order_relaxed);
+        }
+    }
+    state.markTicks = ticks;
+    state.markCPUNanoseconds = cpuTime;
+}
+
+DSConversionStats::ScopedStage::ScopedStage(DSConversionStats *stats, Stage stage) {
+    ThreadState &state = threadState;
+    if(stats == nullptr) {
+        stats = state.context.stats;
+    }
+    if(state.context.stats == stats && state.context.stage == stage) {
+        return;
+    }
+    active = true;
+    // Without stats there are no clocks to read, only the stage to note
+    measuring = stats != nullptr;
+    if(measuring) {
+        chargeElapsedTime();
+    }
+    previousContext = state.context;
+    previousRecordsWallTime = state.recordsWallTime;
+    state.context.stats = stats;
+    state.context.stage = stage;
+    if(measuring) {
+        state.recordsWallTime = true;
+        stats->activeStages[stage]++;
+        stats->recordRSS(DSMemoryMonitor::getCurrentRSSBytes());
+    }
+}
+
+DSConversionStats::ScopedStage::~ScopedStage() {
+    if(!active) {
+        return;
+    }
+    if(measuring) {
+        DSConversionStats *stats = threadState.context.stats;
+        stats->recordRSS(DSMemoryMonitor::getCurrentRSSBytes());
+        stats->activeStages[threadState.context.stage]--;
+        chargeElapsedTime();
+    }
+    threadState.context = previousContext;
+    threadState.recordsWallTime = previousRecordsWallTime;
+}
+
+DSConversionStats::ScopedTask::ScopedTask(const Context &context) {
+    ThreadState &state = threadState;
+    if(context.stats == state.context.stats && context.stage == state.context.stage && !state.recordsWallTime) {
+        return;
+    }
+    active = true;
+    measuring = context.stats != nullptr || state.context.stats != nullptr;
+    if(measuring) {
+        chargeElapsedTime();
+    }
+    previousContext = state.context;
+    previousRecordsWallTime = state.recordsWallTime;
+    state.context = context;
+    state.recordsWallTime = false;
+}
+
+DSConversionStats::ScopedTask::~ScopedTask() {
+    if(!active) {
+        return;
+    }
+    if(measuring) {
+        chargeElapsedTime();
+    }
+    threadState.context = previousContext;
+    threadState.recordsWallTime = previousRecordsWallTime;
+}
+
+double DSConversionStats::getWallSeconds(Stage stage) const {
+    return juce::Time::highResolutionTicksToSeconds(wallTicks[stage].load());
+}
+
+double DSConversionStats::getCPUSeconds(Stage stage) const {
+    return (double) cpuNanoseconds[stage].load() * 1.0e-9;
+}
+
+juce::int64 DSConversionStats::getCounter(Stage stage, Counter counter) const {
+    return counters[stage][counter].load();
+}
+
+juce::int64 DSConversionStats::getTotal(Counter counter) const {
+    juce::int64 total = 0;
+    for (int stage = 0; stage < numStages; stage++) {
+        total += counters[stage][counter].load();
+    }
+    return total;
+}
+
+void DSConversionStats::merge(const DSConversionStats &other) {
+    for (int stage = 0; stage < numStages; stage++) {
+        wallTicks[stage] += other.wallTicks[stage].load();
+        cpuNanoseconds[stage] += other.cpuNanoseconds[stage].load();
+        peakRSSBytes[stage] = juce::jmax(peakRSSBytes[stage].load(), other.peakRSSBytes[stage].load());
+        for (int counter = 0; counter < numCounters; counter++) {
+            counters[stage][counter] += other.counters[stage][counter].load();
+        }
+    }
+}
+
+void DSConversionStats::addToJSON(juce::DynamicObject &report) const {
+    auto *stages = new juce::DynamicObject();
+    report.setProperty("stages", juce::var(stages));
+    auto *totals = new juce::DynamicObject();
+    report.setProperty("totals", juce::var(totals));
+    
+    double totalWallSeconds = 0.0;
+    double totalCPUSeconds = 0.0;
+    juce::int64 totalPeakRSSBytes = 0;
+    for (int stageIndex = 0; stageIndex < numStages; stageIndex++) {
+        Stage stage = (Stage) stageIndex;
+        auto *stageObject = new juce::DynamicObject();
+        stages->setProperty(getStageName(stage), juce::var(stageObject));
+        stageObject->setProperty("wallSeconds", getWallSeconds(stage));
+        stageObject->setProperty("cpuSeconds", getCPUSeconds(stage));
+        stageObject->setProperty("peakRSSBytes", getPeakRSSBytes(stage));
+        for (int counter = 0; counter < numCounters; counter++) {
+            stageObject->setProperty(getCounterName((Counter) counter), getCounter(stage, (Counter) counter));
+        }
+        totalWallSeconds += getWallSeconds(stage);
+        totalCPUSeconds += getCPUSeconds(stage);
+        totalPeakRSSBytes = juce::jmax(totalPeakRSSBytes, getPeakRSSBytes(stage));
+    }
+    
+    totals->setProperty("wallSeconds", totalWallSeconds);
+    totals->setProperty("cpuSeconds", totalCPUSeconds);
+    totals->setProperty("peakRSSBytes", totalPeakRSSBytes);
+    for (int counter = 0; counter < numCounters; counter++) {
+        totals->setProperty(getCounterName((Counter) counter), getTotal((Counter) counter));
+    }
+}
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    DSConversionStats.h
+    Created: 18 Oct 2026 11:41:26pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Wall time, CPU time and I/O counters for each stage of converting one instrument (or, once
+// merged, of a whole run).
+//
+// Every thread has a current context: the stats and the stage it is working for. Stages
+// are entered with ScopedStage, the scheduler carries the context over to the tasks it
+// runs, and the I/O code simply calls count(), so nothing has to pass the stats around.
+// The stage is kept even when nothing is being measured, for DSAllocationTracker.
+// Time is charged to whichever stage is current, so a nested stage's time isn't counted
+// twice. Only the thread that entered a stage adds to its wall time; tasks add CPU time.
+class DSConversionStats {
+public:
+    enum Stage {
+        // Reading the EXS or SFZ file
+        stageLoad,
+        // Building the instrument's value tree from it
+        stageParse,
+        stageHunt,
+        stageProbe,
+        stageRender,
+        stageEmit,
+        numStages
+    };
+    
+    enum Counter {
+        counterFilesStatted,
+        counterBytesRead,
+        counterBytesWritten,
+        counterReadersOpened,
+        counterRegionsEmitted,
+        counterSamplesRendered,
+        numCounters
+    };
+    
+    struct Context {
+        DSConversionStats *stats = nullptr;
+        Stage stage = numStages;
+    };
+    
+    DSConversionStats();
+    
+    static const char *getStageName(Stage stage);
+    static const char *getCounterName(Counter counter);
+    
+    static Context getCurrentContext();
+    
+    // Adds to a counter of the calling thread's current stage, if there is one
+    static void count(Counter counter, juce::int64 amount = 1);
+    // Whether the calling thread has a current stage, for counts that cost something to find out
+    static bool isCounting();
+    
+    // Makes a stage current on the calling thread for as long as it exists. With stats set to
+    // nullptr the thread's current stats (if any) are kept and only the stage changes.
+    class ScopedStage {
+    public:
+        ScopedStage(DSConversionStats *stats, Stage stage);
+        ~ScopedStage();
+    private:
+        bool active = false;
+        bool measuring = false;
+        Context previousContext;
+        bool previousRecordsWallTime = false;
+        JUCE_DECLARE_NON_COPYABLE (ScopedStage)
+    };
+    
+    // Runs a task under a context captured on another thread, charging only its CPU time
+    class ScopedTask {
+    public:
+        ScopedTask(const Context &context);
+        ~ScopedTask();
+    private:
+        bool active = false;
+        bool measuring = false;
+        Context previousContext;
+        bool previousRecordsWallTime = false;
+        JUCE_DECLARE_NON_COPYABLE (ScopedTask)
+    };
+    
+    double getWallSeconds(Stage stage) const;
+    double getCPUSeconds(Stage stage) const;
+    juce::int64 getCounter(Stage stage, Counter counter) const;
+    juce::int64 getTotal(Counter counter) const;
+    
+    // The most memory the process had resident while each stage was running. Sampled when
+    // a stage starts and ends, and in between by a DSMemoryMonitor if one watches these stats.
+    // The process is shared, so with several conversions at once this is an upper bound.
+    void recordRSS(juce::int64 rssBytes);
+    juce::int64 getPeakRSSBytes(Stage stage) const;
+    
+    // Asks the conversion to give up, e.g. because memory is running out. The stage code
+    // checks isCurrentConversionAborted() between units of work.
+    void abort() { aborted = true; }
+    bool isAborted() const { return aborted.load(); }
+    static bool isCurrentConversionAborted();
+    
+    // Adds another set of stats into this one, e.g. to total up a batch
+    void merge(const DSConversionStats &other);
+    
+    // Adds "stages": {"<stage>": {"wallSeconds", "cpuSeconds", "peakRSSBytes", <counters>...}}
+    // and "totals" (the same, summed over the stages, with the highest peak) to a report
+    void addToJSON(juce::DynamicObject &report) const;
+    
+private:
+    static void chargeElapsedTime();
+    static juce::int64 getThreadCPUNanoseconds();
+    
+    std::atomic<juce::int64> wallTicks[numStages];
+    std::atomic<juce::int64> cpuNanoseconds[numStages];
+    std::atomic<juce::int64> counters[numStages][numCounters];
+    std::atomic<juce::int64> peakRSSBytes[numStages];
+    // How many threads are in each stage right now, for recordRSS
+    std::atomic<int> activeStages[numStages];
+    std::atomic<bool> aborted { false };
+    
+    JUCE_DECLARE_NON_COPYABLE (DSConversionStats)
+};
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    DSDirectoryIndex.cpp
+    Created: 18 Oct 2026 8:03:14pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSDirectoryIndex.h"
+#include "DSConversionStats.h"
+
+// How long a listing is trusted before its directory's modification time is checked again
+static const juce::uint32 listingRevalidationMilliseconds = 2000;
+
+bool DSDirectoryIndex::fileExists(const juce::File &file) {
+    std::shared_ptr<const Listing> listing = getListing(file.getParentDirectory());
+    return listing->fileNames.contains(getLookupName(file.getFileName()));
+}
+
+void DSDirectoryIndex::clear() {
+    const juce::ScopedLock scopedLock(lock);
+    listings.clear();
+}
+
+// The default file systems on macOS and Windows ignore case, so the index does too
+juce::String DSDirectoryIndex::getLookupName(const juce::String &fileName) {
+#if JUCE_MAC || JUCE_WINDOWS
+    return fileName.toLowerCase();
+#else
+    return fileName;
+#endif
+}
+
+std::shared_ptr<const DSDirectoryIndex::Listing> DSDirectoryIndex::getListing(const juce::File &directory) {
+    const juce::String key = directory.getFullPathName();
+    const juce::uint32 now = juce::Time::getMillisecondCounter();
+    
+    std::shared_ptr<const Listing> listing;
+    {
+        const juce::ScopedLock scopedLock(lock);
+        auto found = listings.find(key);
+        if(found != listings.end()) {
+            listing = found->second;
+        }
+    }
+    
+    // The directory is read outside the lock so one slow folder doesn't hold up the rest
+    if(listing != nullptr && now - listing->lastChecked < listingRevalidationMilliseconds) {
+        return listing;
+    }
+    DSConversionStats::count(DSConversionStats::counterFilesStatted, 2);
+    if(listing != nullptr && listing->exists == directory.isDirectory() && listing->modificationTime == directory.getLastModificationTime()) {
+        auto revalidated = std::make_shared<Listing>(*listing);
+        revalidated->lastChecked = now;
+        listing = revalidated;
+    } else {
+        listing = readListing(directory);
+    }
+    
+    const juce::ScopedLock scopedLock(lock);
+    listings[key] = listing;
+    return listing;
+}
+
+std::shared_ptr<const DSDirectoryIndex::Listing> DSDirectoryIndex::readListing(const juce::File &directory) {
+    auto listing = std::make_shared<Listing>();
+    listing->lastChecked = juce::Time::getMillisecondCounter();
+    listing->exists = directory.isDirectory();
+    if(!listing->exists) {
+        return listing;
+    }
+    
+    listing->modificationTime = directory.getLastModificationTime();
+    for (auto &child : directory.findChildFiles(juce::File::findFiles, false)) {
+        listing->fileNames.add(getLookupName(child.getFileName()));
+    }
+    DSConversionStats::count(DSConversionStats::counterFilesStatted, listing->fileNames.size());
+    return listing;
+}
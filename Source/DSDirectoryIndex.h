@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+    DSDirectoryIndex.h
+    Created: 18 Oct 2026 8:03:14pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+
+// Answers "does this file exist?" from cached directory listings. Sample hunting asks
+// this for every candidate location of every sample, and a long-running process sees
+// the same sample folders again and again. A listing is checked against its
+// directory's modification time once it's more than a couple of seconds old.
+// Thread-safe.
+class DSDirectoryIndex {
+public:
+    bool fileExists(const juce::File &file);
+    void clear();
+    
+private:
+    struct Listing {
+        bool exists = false;
+        juce::Time modificationTime;
+        juce::uint32 lastChecked = 0;
+        juce::SortedSet<juce::String> fileNames;
+    };
+    
+    std::shared_ptr<const Listing> getListing(const juce::File &directory);
+    static std::shared_ptr<const Listing> readListing(const juce::File &directory);
+    static juce::String getLookupName(const juce::String &fileName);
+    
+    juce::CriticalSection lock;
+    std::map<juce::String, std::shared_ptr<const Listing>> listings;
+};
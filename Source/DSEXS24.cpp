@@ -9,6 +9,8 @@
 */
 
 #include "DSEXS24.h"
+#include "DSConversionStats.h"
+#include "DSInstrumentation.h"
 
 bool DSEXS24::loadExs(juce::File file) {
     if (!file.existsAsFile()) {
@@ -16,10 +18,30 @@ bool DSEXS24::loadExs(juce::File file) {
         return false;
     }
     
+    std::unique_ptr<juce::FileInputStream> fileInputStream = file.createInputStream();
+    if(fileInputStream == nullptr) {
+        DBG("Unable to open file <<%s>>" << file.getFullPathName());
+        return false;
+    }
+    return loadExs(*fileInputStream);
+}
+
+bool DSEXS24::loadExs(const void *data, size_t size) {
+    juce::MemoryInputStream memoryInputStream(data, size, false);
+    return loadExs(memoryInputStream);
+}
+
+// The stream has to be seekable: the chunks are read by absolute position.
+bool DSEXS24::loadExs(juce::InputStream &stream) {
+    DS_INSTRUMENT_SCOPE ("exs.loadExs");
+    // Keeps whatever stats the caller is measuring, if any
+    DSConversionStats::ScopedStage scopedStage(nullptr, DSConversionStats::stageLoad);
+    name.clear();
     zones.clear();
+    groups.clear();
     samples.clear();
     
-    std::unique_ptr<juce::FileInputStream> inputStream = file.createInputStream();
+    juce::InputStream *inputStream = &stream;
     
     inputStream->setPosition(16);
     
@@ -46,6 +68,7 @@ bool DSEXS24::loadExs(juce::File file) {
 
     juce::int64 i = 0;
     juce::int64 data_size = inputStream->getTotalLength();
+    DSConversionStats::count(DSConversionStats::counterBytesRead, data_size);
 
     while (i + 84 < data_size) {
         inputStream->setPosition(i);
@@ -63,21 +86,24 @@ bool DSEXS24::loadExs(juce::File file) {
 
         juce::int64 chunk_type = ((sig & 0x0F000000) >> 24);
         
-        if (chunk_type == 0x01) {
+        if (chunk_type == 0x00) {
+            inputStream->setPosition(i + 20);
+            name = readFixedLengthString(inputStream, 64);
+        } else if (chunk_type == 0x01) {
             if (size < 104) {
                 return false;
             }
             DBG("Zone encountered");
-            zones.add(readZone(inputStream.get(), i, size + 84, bigEndian));
+            zones.add(readZone(inputStream, i, size + 84, bigEndian));
         } else if (chunk_type == 0x02) {
             DBG("Group encountered");
-            groups.add(readGroup(inputStream.get(), i, size + 84, bigEndian));
+            groups.add(readGroup(inputStream, i, size + 84, bigEndian));
         } else if (chunk_type == 0x03) {
-            if (size != 336 && size != 592 && size != 600 && size != 1624) {
+            if (!isValidSampleChunkSize(size)) {
                 return false;
             }
             DBG("Sample encountered");
-            samples.add(readSample(inputStream.get(), i, size + 84, bigEndian));
+            samples.add(readSample(inputStream, i, size + 84, bigEndian));
         } else {
             DBG("Blank chunk type");
         }
@@ -90,7 +116,135 @@ bool DSEXS24::loadExs(juce::File file) {
     return true;
 }
 
-DSEXS24Zone DSEXS24::readZone(juce::FileInputStream *inputStream, juce::int64 i, juce::int64 size, bool bigEndian) {
+// Chunk sizes after the 84-byte chunk header. The zone chunk is the larger, newer layout
+// that carries the zone volume as a float.
+static const int exsChunkHeaderSize = 84;
+static const int exsHeaderChunkSize = 40;
+static const int exsZoneChunkSize = 136;
+static const int exsGroupChunkSize = 88;
+
+static void writeExsInt(juce::uint8 *bytes, juce::uint32 value, bool bigEndian) {
+    for (int i = 0; i < 4; i++) {
+        int shift = bigEndian ? 8 * (3 - i) : 8 * i;
+        bytes[i] = (juce::uint8) (value >> shift);
+    }
+}
+
+// Fixed-length and NUL-padded; anything too long is cut short
+static void writeExsString(juce::uint8 *bytes, const juce::String &text, int length) {
+    size_t numBytes = juce::jmin((size_t) length - 1, text.getNumBytesAsUTF8());
+    memcpy(bytes, text.toRawUTF8(), numBytes);
+}
+
+// A zeroed chunk with its header filled in
+static juce::MemoryBlock createExsChunk(int type, int id, int size, const juce::String &name, bool bigEndian) {
+    juce::MemoryBlock chunk ((size_t) (exsChunkHeaderSize + size), true);
+    auto *bytes = static_cast<juce::uint8 *>(chunk.getData());
+    writeExsInt(bytes, 0x00000101u | ((juce::uint32) type << 24), bigEndian);
+    writeExsInt(bytes + 4, (juce::uint32) size, bigEndian);
+    writeExsInt(bytes + 8, (juce::uint32) id, bigEndian);
+    memcpy(bytes + 16, bigEndian ? "SOBT" : "TBOS", 4);
+    writeExsString(bytes + 20, name, 64);
+    return chunk;
+}
+
+bool DSEXS24::saveExs(juce::File file, bool bigEndian, int sampleChunkSize) {
+    juce::MemoryOutputStream outputStream;
+    if(!saveExs(outputStream, bigEndian, sampleChunkSize)) {
+        return false;
+    }
+    if(!file.replaceWithData(outputStream.getData(), outputStream.getDataSize())) {
+        DBG("Unable to write file <<%s>>" << file.getFullPathName());
+        return false;
+    }
+    return true;
+}
+
+// Every field loadExs reads is written at the offset it reads it from, so that loading
+// the result gives back the same zones, groups, samples and round-robin chains.
+bool DSEXS24::saveExs(juce::OutputStream &outputStream, bool bigEndian, int sampleChunkSize) {
+    if(!isValidSampleChunkSize(sampleChunkSize)) {
+        DBG("Unsupported sample chunk size " << sampleChunkSize);
+        return false;
+    }
+    
+    if(!outputStream.write(createExsChunk(0x00, 0, exsHeaderChunkSize, name, bigEndian).getData(), exsChunkHeaderSize + exsHeaderChunkSize)) {
+        return false;
+    }
+    
+    for (auto &zone : zones) {
+        juce::MemoryBlock chunk = createExsChunk(0x01, zone.id, exsZoneChunkSize, zone.name, bigEndian);
+        auto *bytes = static_cast<juce::uint8 *>(chunk.getData());
+        bytes[84] = (juce::uint8) ((zone.oneShot ? 1 : 0) | (zone.pitch ? 0 : 2) | (zone.reverse ? 4 : 0)
+                                   | (zone.velocityRangeOn ? 8 : 0) | (zone.output >= 0 ? 64 : 0));
+        bytes[85] = (juce::uint8) zone.key;
+        bytes[86] = (juce::uint8) zone.fineTuning;
+        bytes[87] = (juce::uint8) zone.pan;
+        // Older readers only know the whole-dB volume here; loadExs prefers the float below
+        bytes[88] = (juce::uint8) juce::roundToInt(zone.volume);
+        bytes[90] = (juce::uint8) zone.keyLow;
+        bytes[91] = (juce::uint8) zone.keyHigh;
+        bytes[93] = (juce::uint8) zone.loVel;
+        bytes[94] = (juce::uint8) zone.hiVel;
+        writeExsInt(bytes + 96, (juce::uint32) zone.sampleStart, bigEndian);
+        writeExsInt(bytes + 100, (juce::uint32) zone.sampleEnd, bigEndian);
+        writeExsInt(bytes + 104, (juce::uint32) zone.loopStart, bigEndian);
+        writeExsInt(bytes + 108, (juce::uint32) zone.loopEnd, bigEndian);
+        writeExsInt(bytes + 112, (juce::uint32) zone.loopCrossfadeMilliseconds, bigEndian);
+        bytes[117] = (juce::uint8) ((zone.loopEnabled ? 1 : 0) | (zone.loopEqualPower ? 2 : 0));
+        bytes[164] = (juce::uint8) zone.coarseTuning;
+        bytes[166] = (juce::uint8) juce::jmax(0, (int) zone.output);
+        writeExsInt(bytes + 172, (juce::uint32) zone.groupIndex, bigEndian);
+        writeExsInt(bytes + 176, (juce::uint32) zone.sampleIndex, bigEndian);
+        writeExsInt(bytes + 188, (juce::uint32) zone.sampleFade, bigEndian);
+        writeExsInt(bytes + 192, (juce::uint32) zone.offset, bigEndian);
+        juce::uint32 volumeBits;
+        memcpy(&volumeBits, &zone.volume, sizeof(volumeBits));
+        writeExsInt(bytes + 208, volumeBits, bigEndian);
+        if(!outputStream.write(chunk.getData(), chunk.getSize())) {
+            return false;
+        }
+    }
+    
+    for (int groupIndex = 0; groupIndex < groups.size(); groupIndex++) {
+        const DSEXS24Group &group = groups.getReference(groupIndex);
+        juce::MemoryBlock chunk = createExsChunk(0x02, groupIndex, exsGroupChunkSize, group.name, bigEndian);
+        auto *bytes = static_cast<juce::uint8 *>(chunk.getData());
+        bytes[84] = (juce::uint8) group.volume;
+        bytes[85] = (juce::uint8) group.pan;
+        bytes[86] = (juce::uint8) group.polyphony;
+        bytes[89] = (juce::uint8) group.velRangeLow;
+        bytes[90] = (juce::uint8) group.velRangeHigh;
+        bytes[157] = (juce::uint8) group.trigger;
+        bytes[158] = (juce::uint8) group.output;
+        // The round-robin chain is stored as a link to the next group
+        writeExsInt(bytes + 164, (juce::uint32) group.exsSequence, bigEndian);
+        if(!outputStream.write(chunk.getData(), chunk.getSize())) {
+            return false;
+        }
+    }
+    
+    for (auto &sample : samples) {
+        bool hasFileName = sampleChunkSize + exsChunkHeaderSize > 420;
+        juce::MemoryBlock chunk = createExsChunk(0x03, sample.id, sampleChunkSize, hasFileName ? sample.name : sample.fileName, bigEndian);
+        auto *bytes = static_cast<juce::uint8 *>(chunk.getData());
+        writeExsInt(bytes + 88, (juce::uint32) sample.length, bigEndian);
+        writeExsInt(bytes + 92, (juce::uint32) sample.sampleRate, bigEndian);
+        bytes[96] = (juce::uint8) sample.bitDepth;
+        writeExsInt(bytes + 112, (juce::uint32) sample.type, bigEndian);
+        writeExsString(bytes + 164, sample.filePath, 256);
+        if(hasFileName) {
+            writeExsString(bytes + 420, sample.fileName, 256);
+        }
+        if(!outputStream.write(chunk.getData(), chunk.getSize())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+DSEXS24Zone DSEXS24::readZone(juce::InputStream *inputStream, juce::int64 i, juce::int64 size, bool bigEndian) {
+    DS_INSTRUMENT_SCOPE ("exs.readZone");
     DSEXS24Zone zone;
 
     inputStream->setPosition(i + 8);
@@ -113,13 +267,13 @@ DSEXS24Zone DSEXS24::readZone(juce::FileInputStream *inputStream, juce::int64 i,
     zone.fineTuning = inputStream->readByte();
 
     inputStream->setPosition(i + 87);
-    zone.pan = twosComplement(inputStream->readByte(), 8);
+    zone.pan = twosComplement((juce::uint8) inputStream->readByte(), 8);
 
     inputStream->setPosition(i + 88);
     zone.volume = twosComplement(inputStream->readShort(), 8);
     
     inputStream->setPosition(i + 164);
-    zone.coarseTuning = twosComplement(inputStream->readByte(), 8);
+    zone.coarseTuning = twosComplement((juce::uint8) inputStream->readByte(), 8);
 
     inputStream->setPosition(i + 90);
     zone.keyLow = inputStream->readByte();
@@ -205,7 +359,8 @@ DSEXS24Zone DSEXS24::readZone(juce::FileInputStream *inputStream, juce::int64 i,
 }
 
 
-DSEXS24Group DSEXS24::readGroup(juce::FileInputStream *inputStream, juce::int64 i, juce::int64 , bool bigEndian) {
+DSEXS24Group DSEXS24::readGroup(juce::InputStream *inputStream, juce::int64 i, juce::int64 , bool bigEndian) {
+    DS_INSTRUMENT_SCOPE ("exs.readGroup");
     DSEXS24Group group;
 
 //    inputStream->setPosition(i + 8);
@@ -267,7 +422,8 @@ DSEXS24Group DSEXS24::readGroup(juce::FileInputStream *inputStream, juce::int64
     return group;
 }
 
-DSEXS24Sample DSEXS24::readSample(juce::FileInputStream *inputStream, juce::int64 i, juce::int64 size, bool bigEndian) {
+DSEXS24Sample DSEXS24::readSample(juce::InputStream *inputStream, juce::int64 i, juce::int64 size, bool bigEndian) {
+    DS_INSTRUMENT_SCOPE ("exs.readSample");
     
     DSEXS24Sample sample;
 
@@ -311,7 +467,7 @@ short DSEXS24::twosComplement(short value, short bits) {
     return value;
 }
 
-juce::String DSEXS24::readFixedLengthString(juce::FileInputStream *inputStream, int length) {
+juce::String DSEXS24::readFixedLengthString(juce::InputStream *inputStream, int length) {
     juce::MemoryBlock buffer (length);
     auto* data = static_cast<char*> (buffer.getData());
     if(inputStream->read(data, length) < length) {
@@ -71,20 +71,34 @@ class DSEXS24 {
 public:
     DSEXS24() {}
     bool loadExs(juce::File file);
+    bool loadExs(juce::InputStream &inputStream);
+    bool loadExs(const void *data, size_t size);
+    
+    // Writes the instrument back out in the binary format, as SOBT (big-endian) or TBOS
+    // (little-endian). sampleChunkSize is the size of each sample chunk after its header:
+    // 336, 592, 600 or 1624. At 336 there's no room for a separate file name, so the
+    // sample's fileName is stored as its name.
+    bool saveExs(juce::File file, bool bigEndian = false, int sampleChunkSize = 592);
+    bool saveExs(juce::OutputStream &outputStream, bool bigEndian = false, int sampleChunkSize = 592);
+    static bool isValidSampleChunkSize(juce::int64 size) { return size == 336 || size == 592 || size == 600 || size == 1624; }
+    
+    const juce::String &getName() const { return name; }
+    void setName(const juce::String &newName) { name = newName; }
     juce::Array<DSEXS24Zone> & getZones() { return zones; }
     juce::Array<DSEXS24Group> & getGroups() { return groups; }
     juce::Array<DSEXS24Sample> & getSamples() { return samples; }
 private:
+    juce::String name;
     juce::Array<DSEXS24Zone> zones;
     juce::Array<DSEXS24Group> groups;
     juce::Array<DSEXS24Sample> samples;
     juce::Array<juce::Array<int>> sequences;
     
-    juce::String readFixedLengthString(juce::FileInputStream *inputStream, int length);
+    juce::String readFixedLengthString(juce::InputStream *inputStream, int length);
     short twosComplement(short value, short bits);
-    DSEXS24Zone readZone(juce::FileInputStream *inputStream, juce::int64 i, juce::int64 size, bool bigEndian);
-    DSEXS24Group readGroup(juce::FileInputStream *inputStream, juce::int64 i, juce::int64 size, bool bigEndian);
-    DSEXS24Sample readSample(juce::FileInputStream *inputStream, juce::int64 i, juce::int64 size, bool bigEndian);
+    DSEXS24Zone readZone(juce::InputStream *inputStream, juce::int64 i, juce::int64 size, bool bigEndian);
+    DSEXS24Group readGroup(juce::InputStream *inputStream, juce::int64 i, juce::int64 size, bool bigEndian);
+    DSEXS24Sample readSample(juce::InputStream *inputStream, juce::int64 i, juce::int64 size, bool bigEndian);
     void readSequences();
     void convertSeqNumbers();
 };
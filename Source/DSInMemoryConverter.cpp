@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    DSInMemoryConverter.cpp
+    Created: 18 Oct 2026 6:40:18pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSInMemoryConverter.h"
+
+DSInMemoryConverter::DSInMemoryConverter(DSSampleResolver &resolver_, DSConversionScheduler *scheduler_)
+    : resolver(resolver_),
+      ownedScheduler(scheduler_ == nullptr ? std::make_unique<DSConversionScheduler>() : nullptr),
+      scheduler(scheduler_ != nullptr ? scheduler_ : ownedScheduler.get()) {
+}
+
+bool DSInMemoryConverter::convertEXS(const void *exsData, size_t exsSize, const juce::String &sampleSetName, DSPresetConverter::OutputFormat format, juce::MemoryBlock &output, DSConversionStats *stats) {
+    DSEXS24 exs;
+    {
+        DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageLoad);
+        if(!exs.loadExs(exsData, exsSize)) {
+            std::cerr << "Instrument \"" << sampleSetName << "\" is not an EXS file." << std::endl;
+            return false;
+        }
+    }
+    
+    DSPresetConverter converter;
+    converter.setStats(stats);
+    converter.setScheduler(scheduler);
+    converter.setSampleResolver(&resolver);
+    converter.parseDSEXS24(exs);
+    
+    if(!converter.huntForSamples(resolver, sampleSetName)) {
+        return false;
+    }
+    if(!converter.convertEXSLoopCrossfadePoints()) {
+        return false;
+    }
+    
+    output.reset();
+    juce::MemoryOutputStream outputStream(output, false);
+    return converter.writeOutput(outputStream, format);
+}
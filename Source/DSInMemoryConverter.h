@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    DSInMemoryConverter.h
+    Created: 18 Oct 2026 6:40:18pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DSPresetConverter.h"
+
+// Converts instruments held in memory into presets held in memory, for embedding the
+// converter in another program. Nothing touches the file system unless the resolver does.
+//
+// convertEXS can be called from several threads at once: every call works on its own
+// converter, and the resolver and scheduler are shared (and must be thread-safe).
+// Samples are only located and probed, never copied; the paths written into the preset
+// are the ones the resolver returns.
+class DSInMemoryConverter {
+public:
+    // Passing nullptr for the scheduler gives the converter one of its own with the
+    // default thread counts.
+    DSInMemoryConverter(DSSampleResolver &resolver, DSConversionScheduler *scheduler = nullptr);
+    
+    // sampleSetName is passed on to the resolver, which the file resolver uses as a
+    // directory name; by convention it's the instrument's name. If stats is given, the
+    // conversion's stage times and counts are added to it.
+    bool convertEXS(const void *exsData, size_t exsSize, const juce::String &sampleSetName, DSPresetConverter::OutputFormat format, juce::MemoryBlock &output, DSConversionStats *stats = nullptr);
+    
+private:
+    DSSampleResolver &resolver;
+    std::unique_ptr<DSConversionScheduler> ownedScheduler;
+    DSConversionScheduler *scheduler;
+};
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    DSInstrumentation.cpp
+    Created: 19 Oct 2026 1:58:44am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSInstrumentation.h"
+
+#if DS_ENABLE_INSTRUMENTATION
+
+namespace {
+    struct ProbeRegistry {
+        juce::CriticalSection lock;
+        juce::Array<DSInstrumentation::Probe *> probes;
+        // Where the timestamp counter and the high-resolution clock stood when the first
+        // probe was registered, to work out the counter's rate
+        juce::uint64 firstTimestamp = 0;
+        juce::int64 firstTicks = 0;
+    };
+
+    ProbeRegistry &getRegistry() {
+        static ProbeRegistry registry;
+        return registry;
+    }
+
+    const char *getKindName(DSInstrumentation::Kind kind) {
+        switch (kind) {
+            case DSInstrumentation::kindTimer:      return "timer";
+            case DSInstrumentation::kindCounter:    return "counter";
+            case DSInstrumentation::kindHistogram:  return "histogram";
+            default:                                return "";
+        }
+    }
+}
+
+DSInstrumentation::Probe::Probe(const char *name_, Kind kind_) : name(name_), kind(kind_) {
+    for (auto &bucket : buckets) {
+        bucket = 0;
+    }
+    ProbeRegistry &registry = getRegistry();
+    const juce::ScopedLock scopedLock(registry.lock);
+    if(registry.probes.isEmpty()) {
+        registry.firstTimestamp = readTimestamp();
+        registry.firstTicks = juce::Time::getHighResolutionTicks();
+    }
+    // The report is keyed by name, so a second probe with the same one would hide the first
+    for (auto *probe : registry.probes) {
+        jassert (strcmp(probe->name, name) != 0);
+    }
+    registry.probes.add(this);
+}
+
+void DSInstrumentation::addToJSON(juce::DynamicObject &report) {
+    ProbeRegistry &registry = getRegistry();
+    const juce::ScopedLock scopedLock(registry.lock);
+
+    double secondsPerTimestamp = 0.0;
+    double elapsedSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - registry.firstTicks);
+    juce::uint64 elapsedTimestamps = readTimestamp() - registry.firstTimestamp;
+    if(elapsedTimestamps > 0) {
+        secondsPerTimestamp = elapsedSeconds / (double) elapsedTimestamps;
+    }
+
+    auto *probes = new juce::DynamicObject();
+    report.setProperty("probes", juce::var(probes));
+    for (auto *probe : registry.probes) {
+        auto *probeObject = new juce::DynamicObject();
+        probes->setProperty(probe->name, juce::var(probeObject));
+        probeObject->setProperty("kind", getKindName(probe->kind));
+        probeObject->setProperty("calls", (juce::int64) probe->calls.load());
+        if(probe->kind == kindTimer) {
+            probeObject->setProperty("seconds", (double) probe->total.load() * secondsPerTimestamp);
+        } else {
+            probeObject->setProperty("total", (juce::int64) probe->total.load());
+        }
+        if(probe->kind == kindCounter) {
+            continue;
+        }
+
+        // Only the buckets that were hit, as [upper bound, count] pairs. Timer buckets are
+        // in timestamp counter ticks.
+        juce::Array<juce::var> histogram;
+        for (int bucket = 0; bucket < numBuckets; bucket++) {
+            juce::uint64 count = probe->buckets[bucket].load();
+            if(count > 0) {
+                histogram.add(juce::Array<juce::var> { (double) std::ldexp(1.0, bucket), (juce::int64) count });
+            }
+        }
+        probeObject->setProperty("histogram", histogram);
+    }
+    report.setProperty("secondsPerTimestamp", secondsPerTimestamp);
+}
+
+void DSInstrumentation::reset() {
+    ProbeRegistry &registry = getRegistry();
+    const juce::ScopedLock scopedLock(registry.lock);
+    for (auto *probe : registry.probes) {
+        probe->calls = 0;
+        probe->total = 0;
+        for (auto &bucket : probe->buckets) {
+            bucket = 0;
+        }
+    }
+}
+
+#else
+
+void DSInstrumentation::addToJSON(juce::DynamicObject &) {
+}
+
+void DSInstrumentation::reset() {
+}
+
+#endif
@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+    DSInstrumentation.h
+    Created: 19 Oct 2026 1:58:44am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if defined (__x86_64__) || defined (__i386__) || defined (_M_X64) || defined (_M_IX86)
+ #if defined (_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+// Set DS_ENABLE_INSTRUMENTATION=1 in the project's preprocessor definitions to build the
+// probes below into the hot paths (EXS zone parsing, SFZ region emission, loop crossfading,
+// sample decoding and encoding). Without it the macros expand to nothing at all.
+#ifndef DS_ENABLE_INSTRUMENTATION
+ #define DS_ENABLE_INSTRUMENTATION 0
+#endif
+
+// Named probes for code too hot for DSConversionStats or DSTrace:
+//
+//     DS_INSTRUMENT_SCOPE ("exs.readZone");              // times the rest of the scope
+//     DS_INSTRUMENT_COUNT ("exs.zones", 1);              // adds to a counter
+//     DS_INSTRUMENT_HISTOGRAM ("render.crossfadeFrames", n);  // records a value
+//
+// Each probe is a function-local static, so its name is looked up once, and recording is a
+// few relaxed atomic adds. Timers read the CPU's timestamp counter (cntvct on ARM), which
+// is converted to seconds when the report is written. Every probe keeps its number of
+// calls, its total and a log2 histogram of the values it saw. Every call site is a probe of
+// its own, so each one needs a name no other call site uses.
+class DSInstrumentation {
+public:
+    static constexpr bool isEnabled() { return DS_ENABLE_INSTRUMENTATION != 0; }
+
+    // Adds "probes" to a report: {"<name>": {"kind", "calls", "total", "histogram"...}}.
+    // Does nothing unless instrumentation is built in.
+    static void addToJSON(juce::DynamicObject &report);
+    // Zeroes every probe, e.g. between benchmark scenarios
+    static void reset();
+
+#if DS_ENABLE_INSTRUMENTATION
+    enum Kind {
+        kindTimer,
+        kindCounter,
+        kindHistogram
+    };
+
+    static const int numBuckets = 64;
+
+    class Probe {
+    public:
+        Probe(const char *name, Kind kind);
+
+        void add(juce::uint64 value) {
+            calls.fetch_add(1, std::memory_order_relaxed);
+            total.fetch_add(value, std::memory_order_relaxed);
+            if(kind != kindCounter) {
+                buckets[getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        friend class DSInstrumentation;
+
+        // Bucket b holds values below 2^b
+        static int getBucket(juce::uint64 value) {
+            int bucket = 0;
+            while (value != 0 && bucket < numBuckets - 1) {
+                value >>= 1;
+                bucket++;
+            }
+            return bucket;
+        }
+
+        const char *name;
+        Kind kind;
+        std::atomic<juce::uint64> calls { 0 };
+        std::atomic<juce::uint64> total { 0 };
+        std::atomic<juce::uint64> buckets[numBuckets];
+
+        JUCE_DECLARE_NON_COPYABLE (Probe)
+    };
+
+    static juce::uint64 readTimestamp() {
+       #if defined (__x86_64__) || defined (__i386__) || defined (_M_X64) || defined (_M_IX86)
+        return (juce::uint64) __rdtsc();
+       #elif defined (__aarch64__)
+        juce::uint64 ticks;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (ticks));
+        return ticks;
+       #else
+        return (juce::uint64) juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    class ScopedTimer {
+    public:
+        ScopedTimer(Probe &probe_) : probe(probe_), start(readTimestamp()) {}
+        ~ScopedTimer() { probe.add(readTimestamp() - start); }
+    private:
+        Probe &probe;
+        juce::uint64 start;
+        JUCE_DECLARE_NON_COPYABLE (ScopedTimer)
+    };
+#endif
+};
+
+#if DS_ENABLE_INSTRUMENTATION
+ #define DS_INSTRUMENT_SCOPE(name) \
+    static DSInstrumentation::Probe JUCE_JOIN_MACRO (dsInstrumentProbe, __LINE__) (name, DSInstrumentation::kindTimer); \
+    DSInstrumentation::ScopedTimer JUCE_JOIN_MACRO (dsInstrumentTimer, __LINE__) (JUCE_JOIN_MACRO (dsInstrumentProbe, __LINE__))
+ #define DS_INSTRUMENT_COUNT(name, amount) \
+    do { static DSInstrumentation::Probe probe (name, DSInstrumentation::kindCounter); probe.add ((juce::uint64) (amount)); } while (false)
+ #define DS_INSTRUMENT_HISTOGRAM(name, value) \
+    do { static DSInstrumentation::Probe probe (name, DSInstrumentation::kindHistogram); probe.add ((juce::uint64) (value)); } while (false)
+#else
+ #define DS_INSTRUMENT_SCOPE(name)
+ #define DS_INSTRUMENT_COUNT(name, amount)      do {} while (false)
+ #define DS_INSTRUMENT_HISTOGRAM(name, value)   do {} while (false)
+#endif
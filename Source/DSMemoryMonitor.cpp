@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+    DSMemoryMonitor.cpp
+    Created: 19 Oct 2026 5:14:31am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSMemoryMonitor.h"
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <sys/resource.h>
+ #include <unistd.h>
+#endif
+#if JUCE_LINUX
+ #include <cstdlib>
+ #include <cstring>
+ #include <fcntl.h>
+#endif
+#if JUCE_MAC
+ #include <mach/mach.h>
+#endif
+
+DSMemoryMonitor::DSMemoryMonitor(juce::int64 maxRSSBytes_, int intervalMilliseconds_)
+    : juce::Thread("Memory monitor"),
+      maxRSSBytes(maxRSSBytes_),
+      intervalMilliseconds(juce::jmax(1, intervalMilliseconds_)) {
+    startThread();
+}
+
+DSMemoryMonitor::~DSMemoryMonitor() {
+    stopThread(1000);
+}
+
+juce::int64 DSMemoryMonitor::getCurrentRSSBytes() {
+#if JUCE_LINUX
+    // Read with plain syscalls: this runs at every stage boundary and shouldn't allocate
+    int fileDescriptor = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+    if(fileDescriptor < 0) {
+        return 0;
+    }
+    char text[128];
+    ssize_t length = read(fileDescriptor, text, sizeof(text) - 1);
+    close(fileDescriptor);
+    if(length <= 0) {
+        return 0;
+    }
+    text[length] = 0;
+    // "<size> <resident> <shared> ..." in pages
+    const char *resident = strchr(text, ' ');
+    if(resident == nullptr) {
+        return 0;
+    }
+    return (juce::int64) strtoll(resident + 1, nullptr, 10) * (juce::int64) sysconf(_SC_PAGESIZE);
+#elif JUCE_MAC
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return (juce::int64) info.resident_size;
+#else
+    return 0;
+#endif
+}
+
+juce::int64 DSMemoryMonitor::getPeakRSSBytes() {
+#if JUCE_LINUX || JUCE_MAC
+    rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+   #if JUCE_MAC
+    return (juce::int64) usage.ru_maxrss;
+   #else
+    // Kilobytes on Linux
+    return (juce::int64) usage.ru_maxrss * 1024;
+   #endif
+#else
+    return 0;
+#endif
+}
+
+DSMemoryMonitor::ScopedConversion::ScopedConversion(DSMemoryMonitor *monitor_, DSConversionStats *stats_, juce::int64 weight)
+    : monitor(monitor_), stats(stats_) {
+    if(monitor == nullptr || stats == nullptr) {
+        return;
+    }
+    const juce::ScopedLock scopedLock(monitor->lock);
+    monitor->conversions.add({ stats, weight });
+}
+
+DSMemoryMonitor::ScopedConversion::~ScopedConversion() {
+    if(monitor == nullptr || stats == nullptr) {
+        return;
+    }
+    const juce::ScopedLock scopedLock(monitor->lock);
+    for (int i = monitor->conversions.size(); --i >= 0;) {
+        if(monitor->conversions.getReference(i).stats == stats) {
+            monitor->conversions.remove(i);
+            break;
+        }
+    }
+}
+
+void DSMemoryMonitor::run() {
+    while (!threadShouldExit()) {
+        sample();
+        wait(intervalMilliseconds);
+    }
+}
+
+void DSMemoryMonitor::sample() {
+    juce::int64 rss = getCurrentRSSBytes();
+    const juce::ScopedLock scopedLock(lock);
+    for (auto &conversion : conversions) {
+        conversion.stats->recordRSS(rss);
+    }
+    if(maxRSSBytes <= 0) {
+        return;
+    }
+    if(rss <= maxRSSBytes) {
+        waitingForRelease = false;
+        return;
+    }
+    if(waitingForRelease && rss < rssAtLastAbort + maxRSSBytes / 10) {
+        return;
+    }
+
+    // One at a time, heaviest first, and only once the last one aborted has finished giving
+    // up: aborting a single conversion is usually enough
+    Conversion *heaviest = nullptr;
+    for (auto &conversion : conversions) {
+        if(conversion.stats->isAborted()) {
+            return;
+        }
+        if(heaviest == nullptr || conversion.weight > heaviest->weight) {
+            heaviest = &conversion;
+        }
+    }
+    if(heaviest != nullptr) {
+        heaviest->stats->abort();
+        waitingForRelease = true;
+        rssAtLastAbort = rss;
+    }
+}
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    DSMemoryMonitor.h
+    Created: 19 Oct 2026 5:14:31am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DSConversionStats.h"
+
+// Samples the process's resident set size on a background thread, charging each sample to the
+// stages that the watched conversions are in at that moment (see DSConversionStats::recordRSS).
+//
+// With a ceiling set, a sample above it aborts the heaviest watched conversion. Conversions
+// notice this through DSConversionStats::isCurrentConversionAborted() and give up, which
+// frees their buffers, so one huge instrument fails on its own instead of the whole batch
+// being killed for running out of memory. Nothing else is aborted until memory has come
+// back under the ceiling: freed memory isn't always returned to the system straight away,
+// and aborting on every sample until it was would fail the whole batch. Only if memory
+// grows by another tenth of the ceiling in the meantime is the next heaviest aborted too.
+class DSMemoryMonitor : private juce::Thread {
+public:
+    // A maxRSSBytes of 0 only records
+    DSMemoryMonitor(juce::int64 maxRSSBytes = 0, int intervalMilliseconds = 50);
+    ~DSMemoryMonitor() override;
+
+    juce::int64 getMaxRSSBytes() const { return maxRSSBytes; }
+
+    // The resident set size now (from /proc/self/statm on Linux, task_info on macOS), and
+    // the most the process has had resident so far (getrusage). Both are 0 where unsupported.
+    static juce::int64 getCurrentRSSBytes();
+    static juce::int64 getPeakRSSBytes();
+
+    // Registers a conversion for as long as it exists. weight ranks the conversions against
+    // each other when one has to be aborted, e.g. DSBatchConverter's cost estimate.
+    class ScopedConversion {
+    public:
+        ScopedConversion(DSMemoryMonitor *monitor, DSConversionStats *stats, juce::int64 weight);
+        ~ScopedConversion();
+    private:
+        DSMemoryMonitor *monitor;
+        DSConversionStats *stats;
+        JUCE_DECLARE_NON_COPYABLE (ScopedConversion)
+    };
+
+private:
+    struct Conversion {
+        DSConversionStats *stats;
+        juce::int64 weight;
+    };
+
+    void run() override;
+    void sample();
+
+    const juce::int64 maxRSSBytes;
+    const int intervalMilliseconds;
+    juce::CriticalSection lock;
+    juce::Array<Conversion> conversions;
+    // Set by an abort and cleared once memory is back under the ceiling
+    bool waitingForRelease = false;
+    juce::int64 rssAtLastAbort = 0;
+};
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    DSMetricsFile.cpp
+    Created: 19 Oct 2026 6:02:47am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSMetricsFile.h"
+
+// Upper bounds of the stage latency buckets, in seconds; +Inf is implied
+const double DSMetricsFile::bucketBounds[numBuckets] = { 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0, 10.0, 60.0, 300.0 };
+
+DSMetricsFile::DSMetricsFile(juce::File file_, DSConversionScheduler &scheduler_, int intervalSeconds)
+    : juce::Thread("Metrics file"),
+      file(file_),
+      scheduler(scheduler_),
+      intervalMilliseconds(1000 * juce::jmax(1, intervalSeconds)) {
+    startThread();
+}
+
+DSMetricsFile::~DSMetricsFile() {
+    stopThread(2000);
+    write();
+}
+
+DSMetricsFile::ScopedActivity::ScopedActivity(DSMetricsFile *metrics_) : metrics(metrics_) {
+    if(metrics != nullptr) {
+        metrics->activeInstruments++;
+    }
+}
+
+DSMetricsFile::ScopedActivity::~ScopedActivity() {
+    if(metrics != nullptr) {
+        metrics->activeInstruments--;
+    }
+}
+
+void DSMetricsFile::addConversion(const DSConversionStats *stats, bool succeeded) {
+    pendingInstruments--;
+    const juce::ScopedLock scopedLock(lock);
+    (succeeded ? numSucceeded : numFailed)++;
+    if(stats == nullptr) {
+        return;
+    }
+    samplesRendered += stats->getTotal(DSConversionStats::counterSamplesRendered);
+    bytesRead += stats->getTotal(DSConversionStats::counterBytesRead);
+    bytesWritten += stats->getTotal(DSConversionStats::counterBytesWritten);
+    for (int stage = 0; stage < DSConversionStats::numStages; stage++) {
+        double seconds = stats->getWallSeconds((DSConversionStats::Stage) stage);
+        stageCounts[stage]++;
+        stageSeconds[stage] += seconds;
+        for (int bucket = 0; bucket < numBuckets; bucket++) {
+            if(seconds <= bucketBounds[bucket]) {
+                stageBuckets[stage][bucket]++;
+            }
+        }
+    }
+}
+
+juce::String DSMetricsFile::getText() {
+    juce::String text;
+    auto addHeader = [&text](const char *name, const char *type, const char *help) {
+        text << "# HELP " << name << " " << help << "\n";
+        text << "# TYPE " << name << " " << type << "\n";
+    };
+
+    const juce::ScopedLock scopedLock(lock);
+    addHeader("exs2ds_conversions_total", "counter", "Instruments converted, by result.");
+    text << "exs2ds_conversions_total{result=\"succeeded\"} " << numSucceeded << "\n";
+    text << "exs2ds_conversions_total{result=\"failed\"} " << numFailed << "\n";
+
+    addHeader("exs2ds_samples_rendered_total", "counter", "Sample files rendered or copied by finished conversions.");
+    text << "exs2ds_samples_rendered_total " << samplesRendered << "\n";
+    addHeader("exs2ds_read_bytes_total", "counter", "Bytes read by finished conversions.");
+    text << "exs2ds_read_bytes_total " << bytesRead << "\n";
+    addHeader("exs2ds_written_bytes_total", "counter", "Bytes written by finished conversions.");
+    text << "exs2ds_written_bytes_total " << bytesWritten << "\n";
+
+    addHeader("exs2ds_stage_duration_seconds", "histogram", "Wall time each instrument spent in each conversion stage.");
+    for (int stage = 0; stage < DSConversionStats::numStages; stage++) {
+        juce::String stageLabel = juce::String("stage=\"") + DSConversionStats::getStageName((DSConversionStats::Stage) stage) + "\"";
+        for (int bucket = 0; bucket < numBuckets; bucket++) {
+            text << "exs2ds_stage_duration_seconds_bucket{" << stageLabel << ",le=\"" << bucketBounds[bucket] << "\"} " << stageBuckets[stage][bucket] << "\n";
+        }
+        text << "exs2ds_stage_duration_seconds_bucket{" << stageLabel << ",le=\"+Inf\"} " << stageCounts[stage] << "\n";
+        text << "exs2ds_stage_duration_seconds_sum{" << stageLabel << "} " << stageSeconds[stage] << "\n";
+        text << "exs2ds_stage_duration_seconds_count{" << stageLabel << "} " << stageCounts[stage] << "\n";
+    }
+
+    addHeader("exs2ds_instruments_pending", "gauge", "Instruments waiting to be converted or being converted.");
+    text << "exs2ds_instruments_pending " << pendingInstruments.load() << "\n";
+    addHeader("exs2ds_instruments_active", "gauge", "Instruments being parsed or converted right now.");
+    text << "exs2ds_instruments_active " << activeInstruments.load() << "\n";
+    addHeader("exs2ds_scheduler_tasks", "gauge", "Tasks queued or running on each of the scheduler's thread pools.");
+    text << "exs2ds_scheduler_tasks{pool=\"io\"} " << scheduler.getNumIOTasks() << "\n";
+    text << "exs2ds_scheduler_tasks{pool=\"cpu\"} " << scheduler.getNumCPUTasks() << "\n";
+    return text;
+}
+
+bool DSMetricsFile::write() {
+    // The textfile collector only reads *.prom files, so the partial file has another extension
+    juce::File partialFile = file.getSiblingFile(file.getFileName() + ".tmp");
+    bool written;
+    {
+        partialFile.deleteFile();
+        // Prometheus wants \n line endings, which replaceWithText() would turn into \r\n
+        juce::FileOutputStream output(partialFile);
+        written = output.openedOk() && output.writeText(getText(), false, false, nullptr);
+        output.flush();
+        written = written && output.getStatus().wasOk();
+    }
+    // replaceFile() renames over the old file in one step, unlike moveFileTo()
+    if(!written || !DSSampleIO::replaceFile(partialFile, file)) {
+        std::cerr << "error: could not write \"" << file.getFullPathName() << "\"." << std::endl;
+        partialFile.deleteFile();
+        return false;
+    }
+    return true;
+}
+
+void DSMetricsFile::run() {
+    while (!threadShouldExit()) {
+        write();
+        wait(intervalMilliseconds);
+    }
+}
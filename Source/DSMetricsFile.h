@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    DSMetricsFile.h
+    Created: 19 Oct 2026 6:02:47am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DSConversionScheduler.h"
+
+// Keeps a file of metrics in the Prometheus text format up to date while a long batch runs,
+// for the node exporter's textfile collector to pick up. Nothing listens on the network; the
+// file is rewritten every interval (and once more when the metrics are destroyed) by writing
+// a sibling file and renaming it over the old one, so the collector never sees half a file.
+//
+// Conversions are added as they finish. Their stats supply the samples rendered, the bytes
+// read and written and the wall time of each stage, which goes into a histogram. The
+// queue depths are read from the scheduler and from the instrument counts kept here.
+class DSMetricsFile : private juce::Thread {
+public:
+    DSMetricsFile(juce::File file, DSConversionScheduler &scheduler, int intervalSeconds = 15);
+    ~DSMetricsFile() override;
+
+    // Instruments handed to the converter that haven't finished yet
+    void addPendingInstruments(int count) { pendingInstruments += count; }
+    // Marks an instrument as being worked on for as long as it exists
+    class ScopedActivity {
+    public:
+        ScopedActivity(DSMetricsFile *metrics);
+        ~ScopedActivity();
+    private:
+        DSMetricsFile *metrics;
+        JUCE_DECLARE_NON_COPYABLE (ScopedActivity)
+    };
+    // Counts a finished instrument. stats may be nullptr.
+    void addConversion(const DSConversionStats *stats, bool succeeded);
+
+    juce::String getText();
+    bool write();
+
+private:
+    void run() override;
+
+    static const int numBuckets = 11;
+    static const double bucketBounds[numBuckets];
+
+    juce::File file;
+    DSConversionScheduler &scheduler;
+    const int intervalMilliseconds;
+
+    std::atomic<int> pendingInstruments { 0 };
+    std::atomic<int> activeInstruments { 0 };
+
+    juce::CriticalSection lock;
+    juce::int64 numSucceeded = 0;
+    juce::int64 numFailed = 0;
+    juce::int64 samplesRendered = 0;
+    juce::int64 bytesRead = 0;
+    juce::int64 bytesWritten = 0;
+    juce::int64 stageBuckets[DSConversionStats::numStages][numBuckets] = {};
+    juce::int64 stageCounts[DSConversionStats::numStages] = {};
+    double stageSeconds[DSConversionStats::numStages] = {};
+};
@@ -9,12 +9,36 @@
 */
 
 #include "DSPresetConverter.h"
+#include "DSSFZOpcodes.h"
+#include "DSInstrumentation.h"
 
- DSPresetConverter::DSPresetConverter() {
-     audioFormatManager.registerBasicFormats();
+DSPresetConverter::DSPresetConverter() {
+}
+
+// One registry for every converter in the process. Registration happens once; after that
+// the manager is only read, which is safe from any thread.
+juce::AudioFormatManager &DSPresetConverter::getAudioFormatManager() {
+    static juce::AudioFormatManager *audioFormatManager = [] {
+        auto *manager = new juce::AudioFormatManager();
+        manager->registerBasicFormats();
+        return manager;
+    }();
+    return *audioFormatManager;
+}
+
+DSConversionScheduler &DSPresetConverter::getScheduler() {
+    if(scheduler != nullptr) {
+        return *scheduler;
+    }
+    if(ownedScheduler == nullptr) {
+        ownedScheduler = std::make_unique<DSConversionScheduler>();
+    }
+    return *ownedScheduler;
 }
 
 void DSPresetConverter::parseDSEXS24(DSEXS24 exs24) {
+    DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageParse);
+    DSTrace::ScopedSpan span("parse");
 
     // Setup the EXS24 data
     juce::Array<DSEXS24Zone> &zones = exs24.getZones();
@@ -31,8 +55,9 @@ void DSPresetConverter::parseDSEXS24(DSEXS24 exs24) {
     for (DSEXS24Zone zone : zones) {
         if(zone.groupIndex < 0) {
             continue;
-        } else if(zone.groupIndex > 100) {
-            printf("This zone's group index is greater than 100. This converter may not support this file.");
+        } else if(zone.groupIndex > 100 && zone.groupIndex >= groups.size()) {
+            // Only a missing group this far out is suspicious; large instruments really have them
+            std::cout << "This zone's group index is greater than 100. This converter may not support this file." << std::endl;
             continue;
         }
         while (zone.groupIndex >= groups.size()) {
@@ -71,6 +96,7 @@ void DSPresetConverter::parseDSEXS24(DSEXS24 exs24) {
         
         for (DSEXS24Zone zone : zones) {
             if (zone.groupIndex == groupIndex) {
+                DS_INSTRUMENT_SCOPE ("parse.zone");
                 juce::ValueTree dsSample("sample");
                 
                 int sampleIndex = zone.sampleIndex;
@@ -150,6 +176,8 @@ void DSPresetConverter::parseDSEXS24(DSEXS24 exs24) {
 }
 
 void DSPresetConverter::parseSFZValueTree(juce::ValueTree sfz) {
+    DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageParse);
+    DSTrace::ScopedSpan span("parse");
     valueTree = juce::ValueTree("DecentSampler");
     juce::ValueTree groupsVT = juce::ValueTree("groups");
     translateSFZRegionProperties(sfz, groupsVT, headerLevelGlobal);
@@ -171,94 +199,46 @@ void DSPresetConverter::parseSFZValueTree(juce::ValueTree sfz) {
 
 void DSPresetConverter::translateSFZRegionProperties(juce::ValueTree sfzRegion, juce::ValueTree &dsEntity, HeaderLevel level) {
     for (int i = 0; i < sfzRegion.getNumProperties(); i++) {
-        juce::String key = sfzRegion.getPropertyName(i).toString();
-        juce::var value =      sfzRegion.getProperty(key);
+        juce::Identifier key = sfzRegion.getPropertyName(i);
+        const DSSFZOpcodes::Opcode *opcode = DSSFZOpcodes::find(key.toString());
         
-        if(level == headerLevelGroup && key == "group_label") {
-            dsEntity.setProperty("name", value, nullptr);
-        } else if(key == "amp_veltrack") {
-            dsEntity.setProperty("ampVelTrack", ((float)value)/100.0f, nullptr);
-        } else if(key == "ampeg_attack") {
-            dsEntity.setProperty("attack", value, nullptr);
-        } else if(key == "ampeg_release") {
-            dsEntity.setProperty("release", value, nullptr);
-        } else if(key == "ampeg_sustain") {
-            dsEntity.setProperty("sustain", value, nullptr);
-        } else if(key == "ampeg_decay") {
-            dsEntity.setProperty("decay", value, nullptr);
-        } else if(key == "group") {
-            dsEntity.setProperty("tags", "voice-group-" + value.toString(), nullptr);
-        } else if(key == "end") {
-            dsEntity.setProperty("end", value, nullptr);
-        } else if(key == "hikey") {
-            dsEntity.setProperty("hiNote", value, nullptr);
-        } else if(key == "hivel") {
-            dsEntity.setProperty("hiVel", value, nullptr);
-        } else if(key == "key") {
-            dsEntity.setProperty("rootNote", value, nullptr);
-            dsEntity.setProperty("loNote", value, nullptr);
-            dsEntity.setProperty("hiNote", value, nullptr);
-        } else if(key == "lokey") {
-            dsEntity.setProperty("loNote", value, nullptr);
-        } else if(key == "loop_end") {
-            dsEntity.setProperty("loopEnd", value, nullptr);
-        } else if(key == "loop_mode") {
-            if(value == "loop_continuous") {
-                dsEntity.setProperty("loopEnabled", (value == "loop_continuous") ? "true" : "false", nullptr);
-            }
-        } else if(key == "loop_start") {
-            dsEntity.setProperty("loopStart", value, nullptr);
-        } else if(key == "lovel") {
-            dsEntity.setProperty("loVel", value, nullptr);
-        } else if(key == "off_by") {
-            dsEntity.setProperty("silencedByTags", "voice-group-" + value.toString(), nullptr);
-        } else if(key == "off_mode") {
-            dsEntity.setProperty("silencingMode", value, nullptr);
-        } else if(key == "offset") {
-            dsEntity.setProperty("start", value, nullptr);
-        } else if(key == "pitch_keycenter") {
-            dsEntity.setProperty("rootNote", value, nullptr);
-        } else if(key == "sample") {
-            dsEntity.setProperty("path", value, nullptr);
-        } else if(key == "seq_position") {
-            dsEntity.setProperty("seqPosition", value, nullptr);
-            dsEntity.setProperty("seqMode", "round_robin", nullptr);
-        } else if(key == "seq_length") {
-            dsEntity.setProperty("seqLength", value, nullptr);
-            dsEntity.setProperty("seqMode", "round_robin", nullptr);
-        } else if(key == "sw_previous") {
-            dsEntity.setProperty("previousNote", value, nullptr);
-        } else if(key == "trigger") {
-            dsEntity.setProperty("trigger", value, nullptr);
-        } else if(key == "tune") {
-            dsEntity.setProperty("tuning", ((int)value)/100.0, nullptr);
-        } else if(key == "volume") {
-            dsEntity.setProperty("volume", value.toString() + "dB", nullptr);
+        if(opcode != nullptr && (!opcode->groupOnly || level == headerLevelGroup)) {
+            DSSFZOpcodes::applyToDecentSampler(*opcode, sfzRegion.getProperty(key), dsEntity);
         } else {
             switch (level) {
                 case headerLevelGlobal:
-                    DBG("<global> opcode " + key + " not supported.");
+                    DBG("<global> opcode " + key.toString() + " not supported.");
                     break;
                 case headerLevelGroup:
-                    DBG("<group> opcode " + key + " not supported.");
+                    DBG("<group> opcode " + key.toString() + " not supported.");
                     break;
                 case headerLevelRegion:
                 default:
-                    DBG("<region> opcode " + key + " not supported.");
+                    DBG("<region> opcode " + key.toString() + " not supported.");
                     break;
             }
         }
     }
 }
 
-void DSPresetConverter::addGenericUI() {
+// The effects and UI that every converted preset gets. They're parsed and serialized once
+// per process rather than once per conversion.
+const DSPresetConverter::GenericUITemplates &DSPresetConverter::getGenericUITemplates() {
+    static const GenericUITemplates templates;
+    return templates;
+}
+
+DSPresetConverter::GenericUITemplates::GenericUITemplates() {
     juce::String effectsXML = "<effects> \
       <effect type=\"lowpass\" frequency=\"22000.0\"/>\
           <effect type=\"chorus\"  mix=\"0.0\" modDepth=\"0.2\" modRate=\"0.2\" />\
           <effect type=\"reverb\" wetLevel=\"0.5\"/>\
         </effects>";
     
-    valueTree.appendChild(juce::ValueTree::fromXml(effectsXML), nullptr);
+    effects = juce::ValueTree::fromXml(effectsXML);
+    juce::MemoryOutputStream effectsStream;
+    writeXMLElement(effectsStream, effects, 1);
+    effectsText = effectsStream.toString();
     
     juce::String uiXML = "<ui width=\"812\" height=\"375\" bgImage=\"Images/background.jpg\">\
         <tab name=\"main\">\
@@ -302,11 +282,205 @@ void DSPresetConverter::addGenericUI() {
         </tab>\
       </ui>";
     
-    valueTree.appendChild(juce::ValueTree::fromXml(uiXML), nullptr);
+    ui = juce::ValueTree::fromXml(uiXML);
+    juce::MemoryOutputStream uiStream;
+    writeXMLElement(uiStream, ui, 1);
+    uiText = uiStream.toString();
+}
+
+void DSPresetConverter::addGenericUI() {
+    const GenericUITemplates &templates = getGenericUITemplates();
+    valueTree.appendChild(templates.effects.createCopy(), nullptr);
+    valueTree.appendChild(templates.ui.createCopy(), nullptr);
+}
+
+// Writes text with the characters that aren't allowed inside an XML attribute escaped.
+// Control characters become numeric references, as XmlElement::writeTo writes them.
+// Runs of plain characters are written straight from the string's UTF-8 buffer.
+static void writeEscapedXMLText(juce::OutputStream &output, const juce::String &text) {
+    const char *utf8 = text.toRawUTF8();
+    const char *runStart = utf8;
+    const char *p = utf8;
+    
+    for (; *p != 0; p++) {
+        const unsigned char character = (unsigned char) *p;
+        juce::String escaped;
+        switch (character) {
+            case '&':  escaped = "&amp;"; break;
+            case '<':  escaped = "&lt;"; break;
+            case '>':  escaped = "&gt;"; break;
+            case '"':  escaped = "&quot;"; break;
+            default:
+                if(character < 0x20 || character == 0x7f) {
+                    escaped = "&#" + juce::String((int) character) + ";";
+                }
+                break;
+        }
+        if(escaped.isEmpty()) {
+            continue;
+        }
+        output.write(runStart, (size_t) (p - runStart));
+        output.writeText(escaped, false, false, nullptr);
+        runStart = p + 1;
+    }
+    output.write(runStart, (size_t) (p - runStart));
+}
+
+void DSPresetConverter::writeXMLElement(juce::OutputStream &output, const juce::ValueTree &element, int depth) {
+    const juce::String indent = juce::String::repeatedString("  ", depth);
+    if(element.hasType("sample")) {
+        DSConversionStats::count(DSConversionStats::counterRegionsEmitted);
+    }
+    
+    output << indent << "<" << element.getType().toString();
+    for (int i = 0; i < element.getNumProperties(); i++) {
+        const juce::Identifier name = element.getPropertyName(i);
+        output << " " << name.toString() << "=\"";
+        writeEscapedXMLText(output, element.getProperty(name).toString());
+        output << "\"";
+    }
+    
+    if(element.getNumChildren() == 0) {
+        output << "/>\n";
+        return;
+    }
+    output << ">\n";
+    
+    for (auto child : element) {
+        // The generic effects and UI are written from their pre-serialized text, unless
+        // something has changed them since they were added.
+        if(depth == 0 && child.hasType("effects") && child.isEquivalentTo(getGenericUITemplates().effects)) {
+            output << getGenericUITemplates().effectsText;
+        } else if(depth == 0 && child.hasType("ui") && child.isEquivalentTo(getGenericUITemplates().ui)) {
+            output << getGenericUITemplates().uiText;
+        } else {
+            writeXMLElement(output, child, depth + 1);
+        }
+    }
+    output << indent << "</" << element.getType().toString() << ">\n";
+}
+
+// Writes the preset as a .dspreset straight from the value tree, without building an
+// XmlElement tree or an in-memory copy of the whole document first.
+bool DSPresetConverter::writeDSPreset(juce::OutputStream &output) {
+    DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageEmit);
+    output << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\n";
+    writeXMLElement(output, valueTree, 0);
+    output.flush();
+    return true;
+}
+
+bool DSPresetConverter::writeDSPreset(juce::File outputFile) {
+    if(outputFile.existsAsFile()) {
+        outputFile.deleteFile();
+    }
+    juce::FileOutputStream output(outputFile);
+    if(output.failedToOpen()) {
+        std::cerr << "error: could not write \"" << outputFile.getFullPathName() << "\": " << output.getStatus().getErrorMessage() << std::endl;
+        return false;
+    }
+    writeDSPreset(output);
+    if(output.getStatus().failed()) {
+        std::cerr << "error: could not write \"" << outputFile.getFullPathName() << "\": " << output.getStatus().getErrorMessage() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Mirrors the value tree one node per object: its type, its properties and its children.
+static juce::var valueTreeToJSON(const juce::ValueTree &tree) {
+    auto *object = new juce::DynamicObject();
+    juce::var result(object);
+    object->setProperty("type", tree.getType().toString());
+    if(tree.hasType("sample")) {
+        DSConversionStats::count(DSConversionStats::counterRegionsEmitted);
+    }
+    
+    auto *properties = new juce::DynamicObject();
+    for (int i = 0; i < tree.getNumProperties(); i++) {
+        const juce::Identifier name = tree.getPropertyName(i);
+        properties->setProperty(name, tree.getProperty(name));
+    }
+    object->setProperty("properties", juce::var(properties));
+    
+    if(tree.getNumChildren() > 0) {
+        juce::Array<juce::var> children;
+        for (auto child : tree) {
+            children.add(valueTreeToJSON(child));
+        }
+        object->setProperty("children", children);
+    }
+    return result;
+}
+
+juce::String DSPresetConverter::getJSON() {
+    DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageEmit);
+    return juce::JSON::toString(valueTreeToJSON(valueTree));
 }
 
-// Convert the current internal valueTree, which is in a basic DecentSampler format, into an SFZ file
+DSPresetConverter::OutputFormat DSPresetConverter::getOutputFormatForFile(const juce::File &outputFile) {
+    if(outputFile.hasFileExtension("dspreset")) {
+        return outputFormatDSPreset;
+    }
+    if(outputFile.hasFileExtension("json")) {
+        return outputFormatJSON;
+    }
+    return outputFormatSFZ;
+}
+
+// Only reads the model, so several outputs of the same instrument can be written at once.
+bool DSPresetConverter::writeOutput(juce::OutputStream &output, OutputFormat format) {
+    DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageEmit);
+    switch (format) {
+        case outputFormatDSPreset:
+            return writeDSPreset(output);
+        case outputFormatJSON:
+            juce::JSON::writeToStream(output, valueTreeToJSON(valueTree));
+            break;
+        case outputFormatSFZ:
+            output.writeText(getSFZ(), false, false, nullptr);
+            break;
+    }
+    output.flush();
+    return true;
+}
+
+// Written beside the target and renamed over it once complete, so a failed write leaves the
+// previous output alone
+bool DSPresetConverter::writeOutputFile(juce::File outputFile) {
+    DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageEmit);
+    DSTrace::ScopedSpan span("emit", outputFile);
+    juce::File partialFile = outputFile.getSiblingFile(outputFile.getFileName() + ".partial");
+    partialFile.deleteFile();
+    juce::int64 bytesWritten = 0;
+    bool written;
+    {
+        juce::FileOutputStream output(partialFile);
+        written = output.openedOk() && writeOutput(output, getOutputFormatForFile(outputFile)) && output.getStatus().wasOk();
+        if(!written) {
+            std::cerr << "error: could not write \"" << outputFile.getFullPathName() << "\": " << output.getStatus().getErrorMessage() << std::endl;
+        }
+        bytesWritten = output.getPosition();
+    }
+    if(written && !DSSampleIO::replaceFile(partialFile, outputFile)) {
+        std::cerr << "error: could not replace \"" << outputFile.getFullPathName() << "\"." << std::endl;
+        written = false;
+    }
+    if(!written) {
+        partialFile.deleteFile();
+        return false;
+    }
+    DSConversionStats::count(DSConversionStats::counterBytesWritten, bytesWritten);
+    return true;
+}
+
+// Convert the current internal valueTree, which is in a basic DecentSampler format, into an SFZ file.
+//
+// Rather than repeating every inherited opcode on every line, opcodes that all regions of a
+// group agree on are moved up to the <group>, opcodes that all groups agree on are moved up to
+// <global>, and the directory shared by every sample goes into <control> default_path.
 juce::String DSPresetConverter::getSFZ() {
+    DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageEmit);
     // Initialize the SFZ file with a header
     juce::String sfz = "// SFZ file created with EXS2ALL by David Hilowitz\n\n";
     
@@ -316,206 +490,296 @@ juce::String DSPresetConverter::getSFZ() {
         return sfz;
     }
     
-    sfz = sfz + "\n<control>\n";
-
-    auto parseSampleAndGroupProperties = [this](juce::String &sfzFile, juce::ValueTree &valueTree, HeaderLevel level) {
-        if(level == headerLevelGroup) {
-             if (valueTree.hasProperty("name")) {
-                 sfzFile = sfzFile + "group_label=" + valueTree.getProperty("name").toString() + " ";
-             }
-        }
-        if(valueTree.hasProperty("path")) {
-            sfzFile = sfzFile + "sample=" + valueTree.getProperty("path").toString() + " ";
-        }
-        if(valueTree.hasProperty("rootNote")) {
-            sfzFile = sfzFile + "pitch_keycenter=" + valueTree.getProperty("rootNote").toString() + " ";
-        }
-        if(valueTree.hasProperty("loNote") ) {
-            sfzFile = sfzFile + "lokey=" + valueTree.getProperty("loNote").toString() + " ";
-        }
-        if(valueTree.hasProperty("hiNote")) {
-            sfzFile = sfzFile + "hikey=" + valueTree.getProperty("hiNote").toString() + " ";
-        }
-        if(valueTree.hasProperty("loVel") && valueTree.getProperty("loVel").toString() != "0") {
-            sfzFile = sfzFile + "lovel=" + valueTree.getProperty("loVel").toString() + " ";
-        }
-        if(valueTree.hasProperty("hiVel") && valueTree.getProperty("hiVel").toString() != "127") {
-            sfzFile = sfzFile + "hivel=" + valueTree.getProperty("hiVel").toString() + " ";
-        }
-        if(valueTree.hasProperty("start") && valueTree.getProperty("start").toString() != "0") {
-            sfzFile = sfzFile + "offset=" + valueTree.getProperty("start").toString() + " ";
-        }
-        if(valueTree.hasProperty("end")) {
-            sfzFile = sfzFile + "end=" + valueTree.getProperty("end").toString() + " ";
-        }
-        if(valueTree.hasProperty("loopEnabled")) {
-            sfzFile = sfzFile + "loop_mode=loop_continuous ";
-        }
-        if(valueTree.hasProperty("loopStart")) {
-            sfzFile = sfzFile + "loop_start=" + valueTree.getProperty("loopStart").toString() + " ";
-        }
-        if(valueTree.hasProperty("loopEnd")) {
-            sfzFile = sfzFile + "loop_end=" + valueTree.getProperty("loopEnd").toString() + " ";
-        }
-        
-        if(valueTree.hasProperty("pan")) {
-            sfzFile = sfzFile + "pan=" + valueTree.getProperty("pan").toString() + " ";
+    const int numOpcodes = DSSFZOpcodes::getNumOpcodes();
+    
+    // The opcodes of one header, indexed like the opcode table
+    struct HeaderOpcodes {
+        juce::StringArray values;
+        juce::Array<bool> present;
+    };
+    struct GroupOpcodes {
+        HeaderOpcodes opcodes;
+        juce::Array<HeaderOpcodes> regions;
+    };
+    
+    auto parseSampleAndGroupProperties = [numOpcodes](juce::ValueTree &valueTree, HeaderLevel level) {
+        HeaderOpcodes header;
+        juce::String value;
+        for (int i = 0; i < numOpcodes; i++) {
+            const DSSFZOpcodes::Opcode &opcode = DSSFZOpcodes::getOpcode(i);
+            bool present = (!opcode.groupOnly || level == headerLevelGroup) && DSSFZOpcodes::getSFZValue(opcode, valueTree, value);
+            header.values.add(present ? value : juce::String());
+            header.present.add(present);
+        }
+        return header;
+    };
+    
+    HeaderOpcodes global = parseSampleAndGroupProperties(groupsValueTree, headerLevelGlobal);
+    juce::Array<GroupOpcodes> groups;
+    for (auto groupValueTree : groupsValueTree) {
+        if(!groupValueTree.hasType("group")) {
+            continue;
         }
-
-        if(valueTree.hasProperty("ampVelTrack") && valueTree.getProperty("ampVelTrack") != "1.0") {
-            float value = valueTree.getProperty("ampVelTrack");
-            if(value >= 0 && value < 1) {
-                sfzFile = sfzFile + "amp_veltrack=" + juce::String((int)(value*100)) + " ";
+        GroupOpcodes group;
+        group.opcodes = parseSampleAndGroupProperties(groupValueTree, headerLevelGroup);
+        for (auto sampleValueTree : groupValueTree) {
+            if(sampleValueTree.hasType(juce::Identifier("sample"))) {
+                DS_INSTRUMENT_SCOPE ("sfz.regionOpcodes");
+                group.regions.add(parseSampleAndGroupProperties(sampleValueTree, headerLevelRegion));
             }
         }
-        if(valueTree.hasProperty("attack")) {
-            sfzFile = sfzFile + "ampeg_attack=" + valueTree.getProperty("attack").toString() + " ";
+        groups.add(group);
+    }
+    
+    // If every child sets an opcode to the same value, the parent's own value (if any) can
+    // never be seen, so it's safe to replace it and drop the opcode from the children.
+    auto hoistCommonOpcodes = [numOpcodes](HeaderOpcodes &parent, juce::Array<HeaderOpcodes *> children) {
+        if(children.isEmpty()) {
+            return;
+        }
+        for (int i = 0; i < numOpcodes; i++) {
+            if(DSSFZOpcodes::getOpcode(i).groupOnly) {
+                continue;
+            }
+            bool shared = true;
+            for (auto *child : children) {
+                if(!child->present[i] || child->values[i] != children.getFirst()->values[i]) {
+                    shared = false;
+                    break;
+                }
+            }
+            if(!shared) {
+                continue;
+            }
+            parent.values.set(i, children.getFirst()->values[i]);
+            parent.present.set(i, true);
+            for (auto *child : children) {
+                child->present.set(i, false);
+            }
         }
-        if(valueTree.hasProperty("release")) {
-            sfzFile = sfzFile + "ampeg_release=" + valueTree.getProperty("release").toString() + " ";
+    };
+    
+    juce::Array<HeaderOpcodes *> groupHeaders;
+    for (auto &group : groups) {
+        juce::Array<HeaderOpcodes *> regionHeaders;
+        for (auto &region : group.regions) {
+            regionHeaders.add(&region);
+        }
+        hoistCommonOpcodes(group.opcodes, regionHeaders);
+        groupHeaders.add(&group.opcodes);
+    }
+    hoistCommonOpcodes(global, groupHeaders);
+    
+    // Find the directory shared by every sample
+    int sampleOpcodeIndex = -1;
+    for (int i = 0; i < numOpcodes; i++) {
+        if(juce::String(DSSFZOpcodes::getOpcode(i).sfzName) == "sample") {
+            sampleOpcodeIndex = i;
         }
-        if(valueTree.hasProperty("sustain")) {
-            sfzFile = sfzFile + "ampeg_sustain=" + valueTree.getProperty("sustain").toString() + " ";
+    }
+    
+    juce::Array<HeaderOpcodes *> allHeaders { &global };
+    for (auto &group : groups) {
+        allHeaders.add(&group.opcodes);
+        for (auto &region : group.regions) {
+            allHeaders.add(&region);
         }
-        if(valueTree.hasProperty("decay")) {
-            sfzFile = sfzFile + "ampeg_decay=" + valueTree.getProperty("decay").toString() + " ";
+    }
+    
+    // Everything up to and including the last "/", or nothing for a bare file name, so the
+    // default path always names a directory
+    auto getDirectory = [](const juce::String &path) {
+        return path.containsChar('/') ? path.upToLastOccurrenceOf("/", true, false) : juce::String();
+    };
+    juce::String defaultPath;
+    bool firstSample = true;
+    for (auto *header : allHeaders) {
+        if(sampleOpcodeIndex < 0 || !header->present[sampleOpcodeIndex]) {
+            continue;
         }
-        if(valueTree.hasProperty("seqPosition")) {
-            sfzFile = sfzFile + "seq_position=" + valueTree.getProperty("seqPosition").toString() + " ";
+        juce::String directory = getDirectory(header->values[sampleOpcodeIndex]);
+        if(firstSample) {
+            defaultPath = directory;
+            firstSample = false;
         }
-        if(valueTree.hasProperty("seqLength")) {
-            sfzFile = sfzFile + "seq_length=" + valueTree.getProperty("seqLength").toString() + " ";
+        while(defaultPath.isNotEmpty() && !directory.startsWith(defaultPath)) {
+            defaultPath = getDirectory(defaultPath.dropLastCharacters(1));
         }
-        if(valueTree.hasProperty("tags")) {
-            if(valueTree.getProperty("tags").toString().contains("voice-group-")) {
-                sfzFile = sfzFile + "group=" + valueTree.getProperty("tags").toString().replace("voice-group-", "") + " ";
+    }
+    if(defaultPath.isNotEmpty()) {
+        for (auto *header : allHeaders) {
+            if(header->present[sampleOpcodeIndex]) {
+                header->values.set(sampleOpcodeIndex, header->values[sampleOpcodeIndex].substring(defaultPath.length()));
             }
         }
-        
-        if(valueTree.hasProperty("silencedByTags")) {
-            sfzFile = sfzFile + "off_by=" + valueTree.getProperty("silencedByTags").toString().replace("voice-group-", "") + " ";
-        }
-        if(valueTree.hasProperty("silencingMode")) {
-            sfzFile = sfzFile + "off_mode=" + valueTree.getProperty("silencingMode").toString() + " ";
-        }
-        
-        
-        if(valueTree.hasProperty("previousNote")) {
-            sfzFile = sfzFile + "sw_previous=" + valueTree.getProperty("previousNote").toString() + " ";
-        }
-        if(valueTree.hasProperty("trigger")) {
-            sfzFile = sfzFile + "trigger=" + valueTree.getProperty("trigger").toString() + " ";
-        }
-        if(valueTree.hasProperty("tuning")) {
-            sfzFile = sfzFile + "tune=" + juce::String((int)((float)valueTree.getProperty("tuning") * 100.0f)) + " ";
-        }
-        if(valueTree.hasProperty("volume")) {
-            sfzFile = sfzFile + "volume=" + juce::String(linearOrDbStringToDb(valueTree.getProperty("volume").toString())) + " ";
+    }
+    
+    auto writeOpcodes = [numOpcodes](juce::String &sfzFile, const HeaderOpcodes &header) {
+        for (int i = 0; i < numOpcodes; i++) {
+            if(header.present[i]) {
+                sfzFile << DSSFZOpcodes::getOpcode(i).sfzName << "=" << header.values[i] << " ";
+            }
         }
     };
     
-    parseSampleAndGroupProperties(sfz, groupsValueTree, headerLevelGlobal);
+    sfz << "\n<control>\n";
+    if(defaultPath.isNotEmpty()) {
+        sfz << "default_path=" << defaultPath << "\n";
+    }
+    
+    if(global.present.contains(true)) {
+        sfz << "<global>";
+        writeOpcodes(sfz, global);
+    }
     sfz << "\n";
     
     // Iterate through the groups and add their samples
-     for (auto groupValueTree : groupsValueTree) {
-         if(!groupValueTree.hasType("group")) {
-             continue;
-         }
-         sfz << "<group>";
-         parseSampleAndGroupProperties(sfz, groupValueTree, headerLevelGroup);
-         sfz << "\n";
+    for (auto &group : groups) {
+        sfz << "<group>";
+        writeOpcodes(sfz, group.opcodes);
+        sfz << "\n";
         
-         for (auto sampleValueTree : groupValueTree) {
-             if(!sampleValueTree.hasType(juce::Identifier("sample"))) {
-                 continue;
-             }
-             
-             sfz << "<region>";
-             parseSampleAndGroupProperties(sfz, sampleValueTree, headerLevelRegion);
-             sfz << "\n";
-         }
-     }
+        for (auto &region : group.regions) {
+            DS_INSTRUMENT_SCOPE ("sfz.region");
+            sfz << "<region>";
+            writeOpcodes(sfz, region);
+            sfz << "\n";
+        }
+        DSConversionStats::count(DSConversionStats::counterRegionsEmitted, group.regions.size());
+        DS_INSTRUMENT_COUNT ("sfz.regions", group.regions.size());
+    }
     return sfz;
 }
 
 
-double DSPresetConverter::linearOrDbStringToDb(const juce::String inputString) {
-    if (inputString.contains("dB")) {
-        return juce::jlimit(
-             (double) -100,
-             (double) 24,
-             inputString.upToFirstOccurrenceOf("dB", false, true).getDoubleValue());
-        
-    } else {
-        return juce::Decibels::gainToDecibels(inputString.getDoubleValue());
-    }
+bool DSPresetConverter::huntForSamples(juce::File inputDirectory, juce::String sampleSetName) {
+    DSFileSampleResolver resolver(inputDirectory);
+    return huntForSamples(resolver, sampleSetName);
 }
 
-
-bool DSPresetConverter::huntForSamples(juce::File inputDirectory, juce::String sampleSetName) {
+bool DSPresetConverter::huntForSamples(DSSampleResolver &resolver, juce::String sampleSetName) {
+    DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageHunt);
+    DSTrace::ScopedSpan span("hunt");
+    missingSamplePaths.clear();
     juce::ValueTree groupsValueTree = valueTree.getChildWithName("groups");
     if(groupsValueTree == juce::ValueTree()) {
         return true;
     }
-    auto parseSampleAndGroupProperties = [this](juce::ValueTree &valueTree, juce::File inputDirectory, juce::String sampleSetName) {
-        if(valueTree.hasProperty("path")) {
-            juce::String path = valueTree.getProperty("path").toString();
-            
-            juce::File sampleFile = juce::File::getCurrentWorkingDirectory().getChildFile(path);
-            if(sampleFile.existsAsFile()) {
-                std::cout << "Sample file \"" << path << "\" found." << std::endl;
-                valueTree.setProperty("path", sampleFile.getFullPathName(), nullptr);
-                return true;
-            }
-            
-            sampleFile = inputDirectory.getChildFile(sampleSetName).getChildFile(path);
-            if(sampleFile.existsAsFile()) {
-//                valueTree.setProperty("path", sampleFile.getRelativePathFrom(inputDirectory), nullptr);
-                valueTree.setProperty("path", sampleFile.getFullPathName(), nullptr);
-                std::cout << "Sample file path changed to \"" << valueTree.getProperty("path").toString() << "\"." << std::endl;
-                return true;
-            }
-            
-            sampleFile = inputDirectory.getChildFile("Samples").getChildFile(path);
-            if(sampleFile.existsAsFile()) {
-//                valueTree.setProperty("path", sampleFile.getRelativePathFrom(inputDirectory), nullptr);
-                valueTree.setProperty("path", sampleFile.getFullPathName(), nullptr);
-                std::cout << "Sample file path changed to \"" << valueTree.getProperty("path").toString() << "\"." << std::endl;
-                return true;
-            }
     
-            std::cerr << "Sample file \"" << path << "\" not found." << std::endl;
-            return false;
+    struct HuntEntry {
+        juce::ValueTree valueTree;
+        bool isSample;
+        juce::String path;
+        juce::String resolvedPath;
+    };
+    
+    // Gather every entity that refers to a sample file
+    juce::Array<HuntEntry> entries;
+    auto addEntry = [&entries](juce::ValueTree &valueTree, bool isSample) {
+        if(valueTree.hasProperty("path")) {
+            HuntEntry entry;
+            entry.valueTree = valueTree;
+            entry.isSample = isSample;
+            entry.path = valueTree.getProperty("path").toString();
+            entries.add(entry);
         }
-        return true;
     };
-
-    parseSampleAndGroupProperties(groupsValueTree, inputDirectory, sampleSetName);
-    // Iterate through the groups and add their samples
-        for (auto groupValueTree : groupsValueTree) {
-            if(!groupValueTree.hasType("group")) {
+    
+    addEntry(groupsValueTree, false);
+    for (auto groupValueTree : groupsValueTree) {
+        if(!groupValueTree.hasType("group")) {
+            continue;
+        }
+        addEntry(groupValueTree, false);
+        
+        for (auto sampleValueTree : groupValueTree) {
+            if(!sampleValueTree.hasType(juce::Identifier("sample"))) {
                 continue;
             }
-            parseSampleAndGroupProperties(groupValueTree, inputDirectory, sampleSetName);
-            
-            for (auto sampleValueTree : groupValueTree) {
-                if(!sampleValueTree.hasType(juce::Identifier("sample"))) {
-                    continue;
-                }
-                if(!parseSampleAndGroupProperties(sampleValueTree, inputDirectory, sampleSetName)) {
-                    std::cerr << "Sample file \"" << sampleValueTree.getProperty("path").toString() << "\" not found." << std::endl;
-                    return false;
+            addEntry(sampleValueTree, true);
+        }
+    }
+    
+    // The lookups are pure file system work, so run them on the I/O pool
+    {
+        DSConversionScheduler::TaskGroup tasks(getScheduler());
+        for (auto &entry : entries) {
+            tasks.addIOTask([&entry, &resolver, sampleSetName] {
+                if(DSConversionStats::isCurrentConversionAborted()) {
+                    return;
                 }
+                entry.resolvedPath = resolver.resolveSample(entry.path, sampleSetName);
+            });
+        }
+        tasks.wait();
+    }
+    if(DSConversionStats::isCurrentConversionAborted()) {
+        return false;
+    }
+    
+    // Apply the results in document order so the log reads the same as a sequential run
+    for (auto &entry : entries) {
+        if(entry.resolvedPath.isEmpty()) {
+            std::cerr << "Sample file \"" << entry.path << "\" not found." << std::endl;
+            missingSamplePaths.addIfNotAlreadyThere(entry.path);
+            if(entry.isSample) {
+                return false;
             }
+            continue;
+        }
+        
+        entry.valueTree.setProperty("path", entry.resolvedPath, nullptr);
+        if(entry.resolvedPath == entry.path) {
+            std::cout << "Sample file \"" << entry.path << "\" found." << std::endl;
+        } else {
+            std::cout << "Sample file path changed to \"" << entry.resolvedPath << "\"." << std::endl;
         }
+    }
     return true;
 }
 
+juce::Array<juce::File> DSPresetConverter::getSampleFiles() {
+    juce::Array<juce::File> sampleFiles;
+    juce::ValueTree groupsValueTree = valueTree.getChildWithName("groups");
+    if(groupsValueTree == juce::ValueTree()) {
+        return sampleFiles;
+    }
+    
+    auto addSampleFile = [&sampleFiles](juce::ValueTree &valueTree) {
+        if(valueTree.hasProperty("path")) {
+            juce::String path = valueTree.getProperty("path").toString();
+            if(juce::File::isAbsolutePath(path)) {
+                sampleFiles.add(juce::File(path));
+            }
+        }
+    };
+    
+    addSampleFile(groupsValueTree);
+    for (auto groupValueTree : groupsValueTree) {
+        if(!groupValueTree.hasType("group")) {
+            continue;
+        }
+        addSampleFile(groupValueTree);
+        
+        for (auto sampleValueTree : groupValueTree) {
+            if(sampleValueTree.hasType(juce::Identifier("sample"))) {
+                addSampleFile(sampleValueTree);
+            }
+        }
+    }
+    return sampleFiles;
+}
+
 // This function needs to do more than just copy samples to the new directory, it needs to
 // also make sure that the paths in the XML are updated to reflect the new location.
 // It also needs to burn the loop crossfades into the wave files.
+//
+// The work is split into stages: the jobs are gathered from the value tree on the calling
+// thread, each sample is then read on the I/O pool, rendered on the CPU pool and written
+// back out on the I/O pool, and finally the results are applied to the value tree in order.
 bool DSPresetConverter::copySamplesOverToNewDirectory(juce::File rootOutputDirectory, juce::String sampleSetName, bool skipAudioProcessing, int overrideBitrate) {
+    DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageRender);
+    DSTrace::ScopedSpan span("copy samples");
     juce::ValueTree groupsValueTree = valueTree.getChildWithName("groups");
     if(groupsValueTree == juce::ValueTree()) {
         return true;
@@ -529,227 +793,70 @@ bool DSPresetConverter::copySamplesOverToNewDirectory(juce::File rootOutputDirec
     int             globalLoopCrossfade = groupsValueTree.getProperty("loopCrossfade", 0);
     juce::String    globalLoopCrossfadeMode = groupsValueTree.getProperty("loopCrossfadeMode", "linear");
     
-    auto processAudioFiles = [this](juce::ValueTree &valueTree, juce::File outputDirectory, juce::String sampleSetName, int start, int end,  bool loopEnabled, int loopStart, int loopEnd, int loopCrossfade, juce::String loopCrossfadeMode, bool simpleCopy, int overrideBitrate) {
+    juce::File outputDirectory = rootOutputDirectory.getChildFile("Samples").getChildFile(sampleSetName);
+    if(outputArchive == nullptr && !outputDirectory.exists()) {
+        juce::Result result = outputDirectory.createDirectory();
+    }
+    
+    if(outputArchive == nullptr && !outputDirectory.exists()) {
+        std::cerr << "Unable to create output directory." << std::endl;
+        return false;
+    }
+    
+    juce::OwnedArray<SampleRenderJob> jobs;
+    juce::StringArray claimedOutputFiles;
+    
+    auto addJob = [&](juce::ValueTree &valueTree, int start, int end,  bool loopEnabled, int loopStart, int loopEnd, int loopCrossfade, juce::String loopCrossfadeMode) {
         if(!valueTree.hasProperty("path")) {
             return true;
         }
         juce::String path = valueTree.getProperty("path").toString();
         
         juce::File sampleFile = juce::File(path);
-        if(!sampleFile.existsAsFile()) {
+        if(sampleResolver == nullptr && !sampleFileExists(sampleFile)) {
             std::cerr << "Sample file \"" << path << "\" not found." << std::endl;
             return false;
         }
         
-
-        if(!outputDirectory.getChildFile("Samples").exists()) {
-            juce::Result result = outputDirectory.getChildFile("Samples").createDirectory();
-        }
+        auto *job = jobs.add(new SampleRenderJob());
+        job->valueTree = valueTree;
+        job->sampleFile = sampleFile;
+        job->simpleCopy = skipAudioProcessing;
+        job->start = start;
+        job->end = end;
+        job->loopEnabled = loopEnabled;
+        job->loopStart = loopStart;
+        job->loopEnd = loopEnd;
+        job->loopCrossfade = loopCrossfade;
+        job->loopCrossfadeMode = loopCrossfadeMode;
+        job->overrideBitrate = overrideBitrate;
         
-        if(!outputDirectory.getChildFile("Samples").getChildFile(sampleSetName).exists()) {
-            juce::Result result = outputDirectory.getChildFile("Samples").getChildFile(sampleSetName).createDirectory();
-        }
-        
-        if(simpleCopy) {
-            // Copy the file
-            bool result = sampleFile.copyFileTo(outputDirectory.getChildFile("Samples").getChildFile(sampleSetName).getChildFile(sampleFile.getFileName()));
-            if(!result) {
-                std::cerr << "Sample file \"" << path << "\" could not be copied." << std::endl;
-                return false;
-            }
-            
-            // Update the path
-            juce::String simpleFilePath = "Samples/" + sampleSetName + "/" + sampleFile.getFileName();
-            valueTree.setProperty("path", simpleFilePath, nullptr);
-            std::cout << "Sample file path changed to \"" << simpleFilePath << "\"." << std::endl;
-            return true;
-        }
-
-        std::unique_ptr<juce::AudioFormatReader> reader (audioFormatManager.createReaderFor (sampleFile));
-    
-        std::unique_ptr<juce::AudioFormat> audioFormat;
-        if(sampleFile.hasFileExtension("wav")) {
-            audioFormat = std::unique_ptr<juce::AudioFormat>(new juce::WavAudioFormat());
-        } else if(sampleFile.hasFileExtension("aif") || sampleFile.hasFileExtension("aiff")) {
-            audioFormat = std::unique_ptr<juce::AudioFormat>(new juce::AiffAudioFormat());
-        } else if(sampleFile.hasFileExtension("flac")) {
-            audioFormat = std::unique_ptr<juce::AudioFormat>(new juce::FlacAudioFormat());
+        if(skipAudioProcessing) {
+            job->outputFile = outputDirectory.getChildFile(sampleFile.getFileName());
         } else {
-            std::cerr << "Sample file \"" << path << "\" is in an unrecognizable format." << std::endl;
-            return false;
-        }
-        
-        // Get the loop points from the input file
-        int numChannels = reader->numChannels;
-        int sourceSampleRate = reader->sampleRate;
-        
-        int bitsPerSample = reader->bitsPerSample;
-        if(overrideBitrate == 16 || overrideBitrate == 24 || overrideBitrate == 32)
-            bitsPerSample = overrideBitrate;
-        int fileLength = (int) reader->lengthInSamples;
-        int fileMetadataLoopStart = reader->metadataValues.getValue("Loop0Start", "0").getIntValue();
-        int fileMetadataLoopEnd = reader->metadataValues.getValue("Loop0End", "0").getIntValue();
-
-        if(fileMetadataLoopStart > 0 && loopStart == 0 && fileMetadataLoopEnd > 0 && loopEnd == -1) {
-            loopEnabled = true;
-            loopStart = fileMetadataLoopStart;
-            loopEnd = fileMetadataLoopEnd;
-        }
-        
-        if(loopEnabled && loopEnd == -1) {
-            loopEnd = fileLength - 1;
-        }
-
-        if(start < 0 || start >= fileLength) {
-            std::cerr << "Sample file \"" << path << "\" has a start point that is out of range." << std::endl;
-            return false;
-        }
-
-        if(end >= fileLength) {
-            std::cerr << "Sample file \"" << path << "\" has an end point that is out of range." << std::endl;
-            return false;
-        }
-
-        if(loopEnabled && end < loopStart) {
-            std::cerr << "Sample file \"" << path << "\" has an end point that is before the loop start point." << std::endl;
-            return false;
-        }
-
-        if(loopEnabled && end < loopEnd) {
-            std::cerr << "Sample file \"" << path << "\" has an end point that is before the loop end point." << std::endl;
-            return false;
-        }
-        
-        if(loopEnabled && (start > (loopStart - loopCrossfade))) {
-            std::cerr << "Sample file \"" << path << "\" has a start point that is after the loop start point - crossfade." << std::endl;
-            return false;
-        }
-        
-        if(start > end) {
-            std::cerr << "Sample file \"" << path << "\" has a start point that is after the end point." << std::endl;
-            return false;
-        }
-
-        
-
-        // Create buffer to read the original file
-        juce::AudioBuffer<float> buffer (numChannels, (int) reader->lengthInSamples);
-        reader->read (&buffer, 0, (int) reader->lengthInSamples, 0, true, true);
-
-        // Create output buffer with the correct size
-        int outputLength = loopEnabled ? (1 + loopEnd - start) : (end + 1 - start);
-        if(outputLength < 0) {
-            std::cerr << "Sample file \"" << path << "\" has an end point that is before the start point." << std::endl;
-            return false;
-        }
-        juce::AudioBuffer<float> outputBuffer (numChannels, outputLength);
-
-        // If the loop is enabled, crossfade it
-        if(loopEnabled) {
-            if(loopEnd < 0) {
-                loopEnd = fileLength - 1;
+            std::unique_ptr<juce::AudioFormat> audioFormat = createAudioFormatForFile(sampleFile);
+            if(audioFormat == nullptr) {
+                std::cerr << "Sample file \"" << path << "\" is in an unrecognizable format." << std::endl;
+                return false;
             }
-            loopStart = juce::jlimit(0, fileLength - 1, loopStart);
-            loopEnd = juce::jlimit(0, fileLength - 1, loopEnd);
             
-            for (int channel = 0; channel < numChannels; ++channel)
-            {
-                int index = 0;
-                int chunk1Length = loopStart - start;
-                // Copy the beginning of the file up to loopStart
-                outputBuffer.copyFrom (channel, index, buffer, channel, start, chunk1Length);
-                index += chunk1Length;
-                
-                // Copy the portion of the loop before the crossfade starts
-                int chunk2Length = loopEnd - loopStart - loopCrossfade;
-                outputBuffer.copyFrom (channel, index, buffer, channel, loopStart, chunk2Length);
-                index += chunk2Length;
-                
-               // Perform the crossfade
-               for (int i = 0; i <= loopCrossfade; ++i)
-               {
-                   float fadeOut = std::cos ((float)i / loopCrossfade * juce::MathConstants<float>::halfPi);
-                   float fadeIn = std::sin ((float)i / loopCrossfade * juce::MathConstants<float>::halfPi);
-                   
-                   float sampleToFadeOut = buffer.getSample (channel, (loopEnd - loopCrossfade) + i);
-                   float sampleToFadeIn = buffer.getSample (channel, (loopStart - loopCrossfade) + i);
-                   
-                   outputBuffer.setSample (channel, index + i,
-                                           sampleToFadeOut * fadeOut +
-                                           sampleToFadeIn * fadeIn);
-               }
-            }
-        } else {
-            int newFileLength = (end - start) + 1;
-            for (int channel = 0; channel < numChannels; ++channel) {
-                // Copy the beginning of the file up to loopStart
-                outputBuffer.copyFrom (channel, 0, buffer, channel, start, newFileLength);
-                
+            // Output names are reserved here rather than on the worker threads, so that two
+            // samples with the same file name can't both claim the same output file.
+            juce::String extension = audioFormat->getFileExtensions()[0];
+            juce::String baseName = sampleFile.getFileNameWithoutExtension();
+            juce::File outputFile = outputDirectory.getChildFile(baseName + extension);
+            int suffix = 2;
+            while((outputArchive == nullptr && outputFile.exists()) || claimedOutputFiles.contains(outputFile.getFullPathName())) {
+                outputFile = outputDirectory.getChildFile(baseName + " (" + juce::String(suffix++) + ")" + extension);
             }
+            claimedOutputFiles.add(outputFile.getFullPathName());
+            job->outputFile = outputFile;
         }
-        
-        // Now that we've adjust 
-        end -= start;
-        if(loopEnabled) {
-            loopStart -= start;
-            loopEnd -= start;
-        }
-        end = juce::jmin(end, outputLength);
-        start = 0;
-
-        // Create the output directory
-        if(!outputDirectory.getChildFile("Samples").exists())
-            outputDirectory.getChildFile("Samples").createDirectory();
-        
-        if(!outputDirectory.getChildFile("Samples").getChildFile(sampleSetName).exists())
-            outputDirectory.getChildFile("Samples").getChildFile(sampleSetName).createDirectory();
-        
-        
-        if(!outputDirectory.getChildFile("Samples").getChildFile(sampleSetName).exists()) {
-            std::cerr << "Unable to create output directory." << std::endl;
-            return false;
-        }
-        
-        // Write the new buffer to the output file
-        juce::File outputFile = outputDirectory.getChildFile("Samples").getChildFile(sampleSetName).getNonexistentChildFile(sampleFile.getFileNameWithoutExtension(), audioFormat->getFileExtensions()[0]);
-        
-        juce::StringPairArray metadata;
-
-        if(loopEnabled) {
-            // Set Loop0Start and Loop0End in metadata
-            metadata.set("Loop0Start", juce::String(loopStart));
-            metadata.set("Loop0End", juce::String(loopEnd));
-            metadata.set("Loop0Identifier",juce::String(0));
-            metadata.set("Loop0Type", juce::String(0));
-            metadata.set("NumSampleLoops", "1");
-        }
-        
-        std::unique_ptr<juce::AudioFormatWriter> writer (audioFormat->createWriterFor (new juce::FileOutputStream (outputFile), sourceSampleRate, numChannels, bitsPerSample, metadata, 0));
-        if (writer.get() != nullptr) {
-            writer->writeFromAudioSampleBuffer (outputBuffer, 0, outputBuffer.getNumSamples());
-            writer->flush();
-        }
-
-        // Update the properties in the value tree
-        juce::String simpleFilePath = "Samples/" + sampleSetName + "/" + outputFile.getFileName();
-        valueTree.setProperty("path", simpleFilePath, nullptr);
-        std::cout << "Sample file path changed to \"" << simpleFilePath << "\"." << std::endl;
-
-        valueTree.setProperty("start", start, nullptr);
-        valueTree.setProperty("end", end, nullptr);
-
-        if(loopEnabled) {
-            valueTree.setProperty("loopEnabled", loopEnabled, nullptr);
-            valueTree.setProperty("loopStart", loopStart , nullptr);
-            valueTree.setProperty("loopEnd", loopEnd, nullptr);
-            valueTree.setProperty("loopCrossfade", 0, nullptr);
-            valueTree.removeProperty("loopCrossfadeMode", nullptr);
-        }
-        
-        return true;        
+        job->outputPath = "Samples/" + sampleSetName + "/" + job->outputFile.getFileName();
+        return true;
     };
 
-    if(!processAudioFiles(groupsValueTree, rootOutputDirectory, sampleSetName, globalStart, globalEnd, globalLoopEnabled, globalLoopStart, globalLoopEnd, globalLoopCrossfade, globalLoopCrossfadeMode,skipAudioProcessing, overrideBitrate))
+    if(!addJob(groupsValueTree, globalStart, globalEnd, globalLoopEnabled, globalLoopStart, globalLoopEnd, globalLoopCrossfade, globalLoopCrossfadeMode))
         return false;
 
     // Iterate through the groups and add their samples
@@ -766,7 +873,7 @@ bool DSPresetConverter::copySamplesOverToNewDirectory(juce::File rootOutputDirec
             int             groupLoopCrossfade = groupValueTree.getProperty("loopCrossfade", globalLoopCrossfade);
             juce::String    groupLoopCrossfadeMode = groupValueTree.getProperty("loopCrossfadeMode", globalLoopCrossfadeMode);
             
-            if(!processAudioFiles(groupValueTree, rootOutputDirectory, sampleSetName, groupStart, groupEnd, groupLoopEnabled, groupLoopStart, groupLoopEnd, groupLoopCrossfade, groupLoopCrossfadeMode, skipAudioProcessing, overrideBitrate))
+            if(!addJob(groupValueTree, groupStart, groupEnd, groupLoopEnabled, groupLoopStart, groupLoopEnd, groupLoopCrossfade, groupLoopCrossfadeMode))
                 return false;
             
             for (auto sampleValueTree : groupValueTree) {
@@ -782,26 +889,403 @@ bool DSPresetConverter::copySamplesOverToNewDirectory(juce::File rootOutputDirec
                 int             sampleLoopCrossfade = sampleValueTree.getProperty("loopCrossfade", groupLoopCrossfade);
                 juce::String    sampleLoopCrossfadeMode = sampleValueTree.getProperty("loopCrossfadeMode", groupLoopCrossfadeMode);
 
-                if(!processAudioFiles(sampleValueTree, rootOutputDirectory, sampleSetName, sampleStart, sampleEnd, sampleLoopEnabled, sampleLoopStart, sampleLoopEnd, sampleLoopCrossfade, sampleLoopCrossfadeMode, skipAudioProcessing, overrideBitrate)) {
+                if(!addJob(sampleValueTree, sampleStart, sampleEnd, sampleLoopEnabled, sampleLoopStart, sampleLoopEnd, sampleLoopCrossfade, sampleLoopCrossfadeMode)) {
                     std::cerr << "A problem was encountered when processing file \"" << sampleValueTree.getProperty("path").toString() << "\". Halting conversion process." << std::endl;
                     return false;
                 }
             }
         }
+    
+    // Run the jobs. The number of jobs in flight is capped so that a fast disk can't pull
+    // an entire library into memory ahead of the renderers.
+    std::atomic<bool> halted { false };
+    {
+        DSConversionScheduler &pools = getScheduler();
+        DSSampleIO &sampleIO = pools.getSampleIO();
+        DSConversionScheduler::TaskGroup tasks(pools);
+        int maxJobsInFlight = 2 * (pools.getNumIOThreads() + pools.getNumCPUThreads());
+        
+        juce::Array<SampleRenderJob *> submissionOrder;
+        if(sampleResolver == nullptr && sampleIO.isReadingInPhysicalOrder()) {
+            juce::Array<juce::File> sourceFiles;
+            for (auto *job : jobs) {
+                sourceFiles.add(job->sampleFile);
+            }
+            for (int index : DSSampleIO::getPhysicalReadOrder(sourceFiles)) {
+                submissionOrder.add(jobs[index]);
+            }
+        } else {
+            for (auto *job : jobs) {
+                submissionOrder.add(job);
+            }
+        }
+        
+        for (auto *job : submissionOrder) {
+            tasks.waitForCapacity(maxJobsInFlight);
+            if(DSConversionStats::isCurrentConversionAborted()) {
+                halted = true;
+            }
+            if(halted) {
+                break;
+            }
+            
+            if(job->simpleCopy) {
+                tasks.addIOTask([this, job, &sampleIO, &halted] {
+                    if(halted) {
+                        return;
+                    }
+                    DSTrace::ScopedSpan span("copy", job->sampleFile);
+                    if(outputArchive != nullptr) {
+                        job->succeeded = readSampleData(job->sampleFile, job->sourceData, sampleIO)
+                            && outputArchive->addEntry(job->outputPath, job->sourceData.getData(), job->sourceData.getSize(), getArchiveCompressionForFile(job->outputFile));
+                        job->sourceData.reset();
+                    } else if(sampleResolver != nullptr) {
+                        job->succeeded = readSampleData(job->sampleFile, job->sourceData, sampleIO)
+                            && sampleIO.writeFile(job->outputFile, job->sourceData.getData(), job->sourceData.getSize());
+                        job->sourceData.reset();
+                    } else {
+                        job->succeeded = sampleIO.copyFile(job->sampleFile, job->outputFile);
+                    }
+                    if(!job->succeeded) {
+                        job->errorMessage = "Sample file \"" + job->sampleFile.getFullPathName() + "\" could not be copied.";
+                        halted = true;
+                        return;
+                    }
+                    DSConversionStats::count(DSConversionStats::counterSamplesRendered);
+                });
+                continue;
+            }
+            
+            tasks.addIOTask([this, job, &sampleIO, &tasks, &halted] {
+                if(halted) {
+                    return;
+                }
+                DSTrace::ScopedSpan span("read", job->sampleFile);
+                if(!readSampleData(job->sampleFile, job->sourceData, sampleIO)) {
+                    job->errorMessage = "Sample file \"" + job->sampleFile.getFullPathName() + "\" could not be read.";
+                    halted = true;
+                    return;
+                }
+                
+                tasks.addCPUTask([this, job, &sampleIO, &tasks, &halted] {
+                    DSTrace::ScopedSpan span("render", job->sampleFile);
+                    if(halted || !renderSample(*job)) {
+                        halted = true;
+                        return;
+                    }
+                    
+                    // Checksumming and deflating are CPU work, so only the append is left to the I/O pool
+                    if(outputArchive != nullptr) {
+                        DSTrace::ScopedSpan compressSpan("compress", job->outputFile);
+                        job->archiveEntry = DSZipWriter::prepareEntry(job->outputPath, job->outputData.getData(), job->outputData.getSize(), getArchiveCompressionForFile(job->outputFile));
+                        job->outputData.reset();
+                    }
+                    
+                    tasks.addIOTask([this, job, &sampleIO, &halted] {
+                        if(halted) {
+                            return;
+                        }
+                        DSTrace::ScopedSpan span("write", job->outputFile);
+                        if(outputArchive != nullptr) {
+                            job->succeeded = outputArchive->addEntry(job->archiveEntry);
+                            job->archiveEntry = DSZipWriter::PreparedEntry();
+                        } else {
+                            job->succeeded = sampleIO.writeFile(job->outputFile, job->outputData.getData(), job->outputData.getSize());
+                            job->outputData.reset();
+                        }
+                        if(!job->succeeded) {
+                            job->errorMessage = "Unable to write \"" + job->outputFile.getFullPathName() + "\".";
+                            halted = true;
+                            return;
+                        }
+                        DSConversionStats::count(DSConversionStats::counterSamplesRendered);
+                    });
+                });
+            });
+        }
+        tasks.wait();
+    }
+    
+    // Jobs that were still queued when the conversion halted are simply skipped, so only
+    // report the ones that actually failed
+    if(halted) {
+        for (auto *job : jobs) {
+            if(job->errorMessage.isNotEmpty()) {
+                std::cerr << job->errorMessage << std::endl;
+                std::cerr << "A problem was encountered when processing file \"" << job->sampleFile.getFullPathName() << "\". Halting conversion process." << std::endl;
+            }
+        }
+        return false;
+    }
+    
+    // Update the value tree in document order
+    for (auto *job : jobs) {
+        job->valueTree.setProperty("path", job->outputPath, nullptr);
+        std::cout << "Sample file path changed to \"" << job->outputPath << "\"." << std::endl;
+        
+        if(job->simpleCopy) {
+            continue;
+        }
+
+        job->valueTree.setProperty("start", job->start, nullptr);
+        job->valueTree.setProperty("end", job->end, nullptr);
+
+        if(job->loopEnabled) {
+            job->valueTree.setProperty("loopEnabled", job->loopEnabled, nullptr);
+            job->valueTree.setProperty("loopStart", job->loopStart , nullptr);
+            job->valueTree.setProperty("loopEnd", job->loopEnd, nullptr);
+            job->valueTree.setProperty("loopCrossfade", 0, nullptr);
+            job->valueTree.removeProperty("loopCrossfadeMode", nullptr);
+        }
+    }
+    return true;
+}
+
+// Samples come through the resolver when there is one, and from the file system otherwise
+bool DSPresetConverter::readSampleData(const juce::File &sampleFile, juce::MemoryBlock &data, DSSampleIO &sampleIO) {
+    if(sampleResolver == nullptr) {
+        return sampleIO.readFile(sampleFile, data);
+    }
+    std::unique_ptr<juce::InputStream> inputStream = sampleResolver->openSample(sampleFile.getFullPathName());
+    if(inputStream == nullptr) {
+        return false;
+    }
+    // A truncated or corrupt archive entry reads short rather than failing
+    juce::int64 expectedSize = inputStream->getTotalLength();
+    data.reset();
+    inputStream->readIntoMemoryBlock(data);
+    DSConversionStats::count(DSConversionStats::counterBytesRead, (juce::int64) data.getSize());
+    DS_INSTRUMENT_HISTOGRAM ("io.resolverSampleBytes", data.getSize());
+    return expectedSize < 0 || (juce::int64) data.getSize() == expectedSize;
+}
+
+std::unique_ptr<juce::AudioFormat> DSPresetConverter::createAudioFormatForFile(const juce::File &sampleFile) {
+    if(sampleFile.hasFileExtension("wav")) {
+        return std::unique_ptr<juce::AudioFormat>(new juce::WavAudioFormat());
+    } else if(sampleFile.hasFileExtension("aif") || sampleFile.hasFileExtension("aiff")) {
+        return std::unique_ptr<juce::AudioFormat>(new juce::AiffAudioFormat());
+    } else if(sampleFile.hasFileExtension("flac")) {
+        return std::unique_ptr<juce::AudioFormat>(new juce::FlacAudioFormat());
+    }
+    return nullptr;
+}
+
+bool DSPresetConverter::sampleFileExists(const juce::File &sampleFile) {
+    DSConversionStats::count(DSConversionStats::counterFilesStatted);
+    return sampleFile.existsAsFile();
+}
+
+// FLAC is already compressed, so deflating it again would only cost time
+DSZipWriter::Compression DSPresetConverter::getArchiveCompressionForFile(const juce::File &sampleFile) {
+    if(sampleFile.hasFileExtension("flac")) {
+        return DSZipWriter::compressionStored;
+    }
+    return DSZipWriter::compressionAuto;
+}
+
+// Decodes job.sourceData, burns in the loop crossfade and encodes the result into
+// job.outputData. Runs on the CPU pool, so it must only touch the job itself.
+bool DSPresetConverter::renderSample(SampleRenderJob &job) {
+    juce::String path = job.sampleFile.getFullPathName();
+    int start = job.start;
+    int end = job.end;
+    bool loopEnabled = job.loopEnabled;
+    int loopStart = job.loopStart;
+    int loopEnd = job.loopEnd;
+    int loopCrossfade = job.loopCrossfade;
+    
+    std::unique_ptr<juce::AudioFormatReader> reader (getAudioFormatManager().createReaderFor (std::make_unique<juce::MemoryInputStream> (job.sourceData, false)));
+    DSConversionStats::count(DSConversionStats::counterReadersOpened);
+    if(reader == nullptr) {
+        job.errorMessage = "Sample file \"" + path + "\" is in an unrecognizable format.";
+        return false;
+    }
+
+    std::unique_ptr<juce::AudioFormat> audioFormat = createAudioFormatForFile(job.sampleFile);
+    if(audioFormat == nullptr) {
+        job.errorMessage = "Sample file \"" + path + "\" is in an unrecognizable format.";
+        return false;
+    }
+    
+    // Get the loop points from the input file
+    int numChannels = reader->numChannels;
+    int sourceSampleRate = reader->sampleRate;
+    
+    int bitsPerSample = reader->bitsPerSample;
+    if(job.overrideBitrate == 16 || job.overrideBitrate == 24 || job.overrideBitrate == 32)
+        bitsPerSample = job.overrideBitrate;
+    int fileLength = (int) reader->lengthInSamples;
+    int fileMetadataLoopStart = reader->metadataValues.getValue("Loop0Start", "0").getIntValue();
+    int fileMetadataLoopEnd = reader->metadataValues.getValue("Loop0End", "0").getIntValue();
+
+    if(fileMetadataLoopStart > 0 && loopStart == 0 && fileMetadataLoopEnd > 0 && loopEnd == -1) {
+        loopEnabled = true;
+        loopStart = fileMetadataLoopStart;
+        loopEnd = fileMetadataLoopEnd;
+    }
+    
+    if(loopEnabled && loopEnd == -1) {
+        loopEnd = fileLength - 1;
+    }
+
+    if(start < 0 || start >= fileLength) {
+        job.errorMessage = "Sample file \"" + path + "\" has a start point that is out of range.";
+        return false;
+    }
+
+    if(end >= fileLength) {
+        job.errorMessage = "Sample file \"" + path + "\" has an end point that is out of range.";
+        return false;
+    }
+
+    if(loopEnabled && end < loopStart) {
+        job.errorMessage = "Sample file \"" + path + "\" has an end point that is before the loop start point.";
+        return false;
+    }
+
+    if(loopEnabled && end < loopEnd) {
+        job.errorMessage = "Sample file \"" + path + "\" has an end point that is before the loop end point.";
+        return false;
+    }
+    
+    if(loopEnabled && (start > (loopStart - loopCrossfade))) {
+        job.errorMessage = "Sample file \"" + path + "\" has a start point that is after the loop start point - crossfade.";
+        return false;
+    }
+    
+    if(start > end) {
+        job.errorMessage = "Sample file \"" + path + "\" has a start point that is after the end point.";
+        return false;
+    }
+
+    // Create buffer to read the original file
+    juce::AudioBuffer<float> buffer (numChannels, (int) reader->lengthInSamples);
+    {
+        DS_INSTRUMENT_SCOPE ("render.decode");
+        reader->read (&buffer, 0, (int) reader->lengthInSamples, 0, true, true);
+    }
+    reader.reset();
+    job.sourceData.reset();
+
+    // Create output buffer with the correct size
+    int outputLength = loopEnabled ? (1 + loopEnd - start) : (end + 1 - start);
+    if(outputLength < 0) {
+        job.errorMessage = "Sample file \"" + path + "\" has an end point that is before the start point.";
+        return false;
+    }
+    juce::AudioBuffer<float> outputBuffer (numChannels, outputLength);
+
+    // If the loop is enabled, crossfade it
+    if(loopEnabled) {
+        if(loopEnd < 0) {
+            loopEnd = fileLength - 1;
+        }
+        loopStart = juce::jlimit(0, fileLength - 1, loopStart);
+        loopEnd = juce::jlimit(0, fileLength - 1, loopEnd);
+        
+        DS_INSTRUMENT_SCOPE ("render.crossfade");
+        DS_INSTRUMENT_HISTOGRAM ("render.crossfadeFrames", loopCrossfade);
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            int index = 0;
+            int chunk1Length = loopStart - start;
+            // Copy the beginning of the file up to loopStart
+            outputBuffer.copyFrom (channel, index, buffer, channel, start, chunk1Length);
+            index += chunk1Length;
+            
+            // Copy the portion of the loop before the crossfade starts
+            int chunk2Length = loopEnd - loopStart - loopCrossfade;
+            outputBuffer.copyFrom (channel, index, buffer, channel, loopStart, chunk2Length);
+            index += chunk2Length;
+            
+           // Perform the crossfade
+           for (int i = 0; i <= loopCrossfade; ++i)
+           {
+               float fadeOut = std::cos ((float)i / loopCrossfade * juce::MathConstants<float>::halfPi);
+               float fadeIn = std::sin ((float)i / loopCrossfade * juce::MathConstants<float>::halfPi);
+               
+               float sampleToFadeOut = buffer.getSample (channel, (loopEnd - loopCrossfade) + i);
+               float sampleToFadeIn = buffer.getSample (channel, (loopStart - loopCrossfade) + i);
+               
+               outputBuffer.setSample (channel, index + i,
+                                       sampleToFadeOut * fadeOut +
+                                       sampleToFadeIn * fadeIn);
+           }
+        }
+    } else {
+        int newFileLength = (end - start) + 1;
+        for (int channel = 0; channel < numChannels; ++channel) {
+            // Copy the beginning of the file up to loopStart
+            outputBuffer.copyFrom (channel, 0, buffer, channel, start, newFileLength);
+            
+        }
+    }
+    
+    // Now that we've adjust 
+    end -= start;
+    if(loopEnabled) {
+        loopStart -= start;
+        loopEnd -= start;
+    }
+    end = juce::jmin(end, outputLength);
+    start = 0;
+    
+    juce::StringPairArray metadata;
+
+    if(loopEnabled) {
+        // Set Loop0Start and Loop0End in metadata
+        metadata.set("Loop0Start", juce::String(loopStart));
+        metadata.set("Loop0End", juce::String(loopEnd));
+        metadata.set("Loop0Identifier",juce::String(0));
+        metadata.set("Loop0Type", juce::String(0));
+        metadata.set("NumSampleLoops", "1");
+    }
+    
+    // Encode into memory; the I/O pool writes the bytes out
+    DSTrace::ScopedSpan encodeSpan("encode", job.outputFile);
+    auto *outputStream = new juce::MemoryOutputStream (job.outputData, false);
+    std::unique_ptr<juce::AudioFormatWriter> writer (audioFormat->createWriterFor (outputStream, sourceSampleRate, numChannels, bitsPerSample, metadata, 0));
+    if (writer.get() == nullptr) {
+        delete outputStream;
+        job.errorMessage = "Unable to create a writer for \"" + job.outputFile.getFullPathName() + "\".";
+        return false;
+    }
+    {
+        DS_INSTRUMENT_SCOPE ("render.encode");
+        writer->writeFromAudioSampleBuffer (outputBuffer, 0, outputBuffer.getNumSamples());
+        writer.reset();
+    }
+
+    job.start = start;
+    job.end = end;
+    job.loopEnabled = loopEnabled;
+    job.loopStart = loopStart;
+    job.loopEnd = loopEnd;
     return true;
 }
 
 // Go through the value tree and convert the EXS loop crossfade value which are in milliseconds to the DecentSampler sample-based format
 bool DSPresetConverter::convertEXSLoopCrossfadePoints() {
+    DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageProbe);
+    DSTrace::ScopedSpan span("probe");
     juce::ValueTree groupsValueTree = valueTree.getChildWithName("groups");
     if(groupsValueTree == juce::ValueTree()) {
         return true;
     }
     
+    struct CrossfadeEntry {
+        juce::ValueTree valueTree;
+        int loopCrossfadeMilliseconds;
+        juce::String path;
+        juce::File sampleFile;
+        double sampleRate = 0;
+    };
+    juce::Array<CrossfadeEntry> entries;
+    
     int globalLoopCrossfadeMilliseconds = groupsValueTree.getProperty("loopCrossfadeMilliseconds", -1);
     groupsValueTree.removeProperty("loopCrossfadeMilliseconds", nullptr);
     
-    auto updateLoopCrossfade = [this](juce::ValueTree &valueTree, int parentLoopCrossfadeMilliseconds) {
+    auto addEntry = [this, &entries](juce::ValueTree &valueTree, int parentLoopCrossfadeMilliseconds) {
         int loopCrossfadeMilliseconds = valueTree.getProperty("loopCrossfadeMilliseconds", parentLoopCrossfadeMilliseconds);
         valueTree.removeProperty("loopCrossfadeMilliseconds", nullptr);
         if(loopCrossfadeMilliseconds == -1) {
@@ -813,21 +1297,23 @@ bool DSPresetConverter::convertEXSLoopCrossfadePoints() {
         }
         juce::String path = valueTree.getProperty("path").toString();
         
+        // A resolver's paths aren't necessarily files; opening them is left to the probe
         juce::File sampleFile = juce::File(path);
-        if(!sampleFile.existsAsFile()) {
+        if(sampleResolver == nullptr && !sampleFileExists(sampleFile)) {
             std::cerr << "Sample file \"" << path << "\" not found." << std::endl;
             return false;
         }
         
-        std::unique_ptr<juce::AudioFormatReader> reader (audioFormatManager.createReaderFor (sampleFile));
-        int sourceSampleRate = reader->sampleRate;
-        
-        valueTree.setProperty("loopCrossfade", (int) ((float) loopCrossfadeMilliseconds * 0.001 * sourceSampleRate), nullptr);
-        
+        CrossfadeEntry entry;
+        entry.valueTree = valueTree;
+        entry.loopCrossfadeMilliseconds = loopCrossfadeMilliseconds;
+        entry.path = path;
+        entry.sampleFile = sampleFile;
+        entries.add(entry);
         return true;
     };
     
-    if(!updateLoopCrossfade(groupsValueTree, 0))
+    if(!addEntry(groupsValueTree, 0))
         return false;
     
     // Iterate through the groups and add their samples
@@ -838,7 +1324,7 @@ bool DSPresetConverter::convertEXSLoopCrossfadePoints() {
         
         int groupLoopCrossfadeMilliseconds = groupValueTree.getProperty("loopCrossfadeMilliseconds", globalLoopCrossfadeMilliseconds);
         groupValueTree.removeProperty("loopCrossfadeMilliseconds", nullptr);
-        if(!updateLoopCrossfade(groupValueTree, groupLoopCrossfadeMilliseconds))
+        if(!addEntry(groupValueTree, groupLoopCrossfadeMilliseconds))
             return false;
         
         for (auto sampleValueTree : groupValueTree) {
@@ -847,19 +1333,78 @@ bool DSPresetConverter::convertEXSLoopCrossfadePoints() {
             }
             
             int sampleLoopCrossfadeMilliseconds = sampleValueTree.getProperty("loopCrossfadeMilliseconds", groupLoopCrossfadeMilliseconds);
-            groupsValueTree.removeProperty("loopCrossfadeMilliseconds", nullptr);
             
-            if(!updateLoopCrossfade(sampleValueTree, sampleLoopCrossfadeMilliseconds)) {
+            if(!addEntry(sampleValueTree, sampleLoopCrossfadeMilliseconds)) {
                 std::cerr << "Sample file \"" << sampleValueTree.getProperty("path").toString() << "\" not found." << std::endl;
                 return false;
             }
         }
     }
+    
+    // Probing the sample headers is I/O-bound
+    {
+        DSConversionScheduler &pools = getScheduler();
+        juce::Array<int> probeOrder;
+        if(sampleResolver == nullptr && pools.getSampleIO().isReadingInPhysicalOrder()) {
+            juce::Array<juce::File> sampleFiles;
+            for (auto &entry : entries) {
+                sampleFiles.add(entry.sampleFile);
+            }
+            probeOrder = DSSampleIO::getPhysicalReadOrder(sampleFiles);
+        } else {
+            for (int i = 0; i < entries.size(); i++) {
+                probeOrder.add(i);
+            }
+        }
+        
+        DSConversionScheduler::TaskGroup tasks(pools);
+        for (int index : probeOrder) {
+            CrossfadeEntry &entry = entries.getReference(index);
+            tasks.addIOTask([this, &entry] {
+                if(DSConversionStats::isCurrentConversionAborted()) {
+                    return;
+                }
+                DSTrace::ScopedSpan span("probe sample", entry.sampleFile);
+                std::unique_ptr<juce::AudioFormatReader> reader;
+                if(sampleResolver != nullptr) {
+                    if(auto inputStream = sampleResolver->openSample(entry.path)) {
+                        reader.reset(getAudioFormatManager().createReaderFor (std::move(inputStream)));
+                        DSConversionStats::count(DSConversionStats::counterReadersOpened);
+                    }
+                } else if(metadataCache != nullptr && metadataCache->getSampleRate(entry.sampleFile, entry.sampleRate)) {
+                    return;
+                } else {
+                    reader.reset(getAudioFormatManager().createReaderFor (entry.sampleFile));
+                    DSConversionStats::count(DSConversionStats::counterReadersOpened);
+                    if(reader != nullptr && metadataCache != nullptr) {
+                        metadataCache->setSampleRate(entry.sampleFile, reader->sampleRate);
+                    }
+                }
+                if(reader != nullptr) {
+                    entry.sampleRate = reader->sampleRate;
+                }
+            });
+        }
+        tasks.wait();
+    }
+    if(DSConversionStats::isCurrentConversionAborted()) {
+        return false;
+    }
+    
+    for (auto &entry : entries) {
+        if(entry.sampleRate <= 0) {
+            std::cerr << "Sample file \"" << entry.path << "\" could not be read." << std::endl;
+            return false;
+        }
+        int sourceSampleRate = (int) entry.sampleRate;
+        entry.valueTree.setProperty("loopCrossfade", (int) ((float) entry.loopCrossfadeMilliseconds * 0.001 * sourceSampleRate), nullptr);
+    }
         
     return true;
 }
 
 bool DSPresetConverter::convertPathsToDesiredDirectory(juce::File inputDirectory, juce::String desiredDirectoryName) {
+    DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageRender);
     juce::ValueTree groupsValueTree = valueTree.getChildWithName("groups");
     if(groupsValueTree == juce::ValueTree()) {
         return true;
@@ -882,7 +1427,7 @@ bool DSPresetConverter::convertPathsToDesiredDirectory(juce::File inputDirectory
         juce::String path = valueTree.getProperty("path").toString();
         
         juce::File sampleFile = juce::File(path);
-        if(!sampleFile.existsAsFile()) {
+        if(!sampleFileExists(sampleFile)) {
             std::cerr << "Sample file \"" << path << "\" not found." << std::endl;
             return false;
         }
@@ -921,6 +1466,7 @@ bool DSPresetConverter::convertPathsToDesiredDirectory(juce::File inputDirectory
 }
 
 bool DSPresetConverter::convertPathsToRelative(juce::File inputDirectory) {
+    DSConversionStats::ScopedStage scopedStage(stats, DSConversionStats::stageRender);
     juce::ValueTree groupsValueTree = valueTree.getChildWithName("groups");
     if(groupsValueTree == juce::ValueTree()) {
         return true;
@@ -933,7 +1479,7 @@ bool DSPresetConverter::convertPathsToRelative(juce::File inputDirectory) {
         juce::String path = valueTree.getProperty("path").toString();
         
         juce::File sampleFile = juce::File(path);
-        if(!sampleFile.existsAsFile()) {
+        if(!sampleFileExists(sampleFile)) {
             std::cerr << "Sample file \"" << path << "\" not found." << std::endl;
             return false;
         }
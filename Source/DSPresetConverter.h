@@ -11,17 +11,42 @@
 #pragma once
 
 #include "DSEXS24.h"
+#include "DSConversionScheduler.h"
+#include "DSSampleResolver.h"
+#include "DSSampleMetadataCache.h"
+#include "DSZipWriter.h"
 
 class DSPresetConverter {
 public:
     DSPresetConverter();
+    
+    // The scheduler runs the I/O and CPU work of hunting, probing and copying samples.
+    // If none is set, a scheduler with the default thread counts is created on first use.
+    void setScheduler(DSConversionScheduler *newScheduler) { scheduler = newScheduler; }
+    // When a resolver is set, samples are read through it instead of the file system.
+    // huntForSamples(DSSampleResolver&, ...) should be given the same resolver.
+    void setSampleResolver(DSSampleResolver *newSampleResolver) { sampleResolver = newSampleResolver; }
+    // Sample rates probed from files on disk are looked up in and added to this cache.
+    void setMetadataCache(DSSampleMetadataCache *newMetadataCache) { metadataCache = newMetadataCache; }
+    // Each stage below adds its times and counts to these stats, if set.
+    void setStats(DSConversionStats *newStats) { stats = newStats; }
+    // When an archive is set, copySamplesOverToNewDirectory adds the samples to it as
+    // Samples/<sampleSetName>/... entries as soon as each one is rendered, and nothing is
+    // written to rootOutputDirectory.
+    void setOutputArchive(DSZipWriter *newOutputArchive) { outputArchive = newOutputArchive; }
     void parseDSEXS24(DSEXS24 exs24);
     void parseSFZValueTree(juce::ValueTree valueTree);
     
     bool huntForSamples(juce::File inputDirectory, juce::String sampleSetName);
+    bool huntForSamples(DSSampleResolver &resolver, juce::String sampleSetName);
     bool convertPathsToDesiredDirectory(juce::File inputDirectory, juce::String desiredDirectoryName);
     bool convertPathsToRelative(juce::File inputDirectory);
     bool convertEXSLoopCrossfadePoints();
+    // Every sample file referenced by the instrument, once per reference. Only meaningful
+    // after huntForSamples has turned the paths into absolute ones.
+    juce::Array<juce::File> getSampleFiles();
+    // The paths, as written in the instrument, that the last huntForSamples couldn't find
+    const juce::StringArray &getMissingSamplePaths() const { return missingSamplePaths; }
     bool copySamplesOverToNewDirectory(juce::File rootOutputDirectory, juce::String sampleSetName, bool skipAudioProcessing, int overrideBitrate);
     
     
@@ -32,20 +57,81 @@ public:
         return valueTree.toXmlString(format);
     }
     juce::String getSFZ();
+    bool writeDSPreset(juce::OutputStream &output);
+    bool writeDSPreset(juce::File outputFile);
+    juce::String getJSON();
+    
+    enum OutputFormat {
+        outputFormatSFZ,
+        outputFormatDSPreset,
+        outputFormatJSON
+    };
+    // .dspreset and .json pick those formats; anything else is written as SFZ.
+    static OutputFormat getOutputFormatForFile(const juce::File &outputFile);
+    bool writeOutput(juce::OutputStream &output, OutputFormat format);
+    bool writeOutputFile(juce::File outputFile);
     
     juce::ValueTree getValueTree() { return valueTree; }
     std::unique_ptr<juce::XmlElement> getXMLObject() { return valueTree.createXml(); }
     
+    // Shared by every converter; the basic formats are registered on first use.
+    static juce::AudioFormatManager &getAudioFormatManager();
+    
     enum HeaderLevel {
         headerLevelGlobal,
         headerLevelGroup,
         headerLevelRegion
     };
 private:
-    juce::AudioFormatManager audioFormatManager;
+    // Everything needed to render one sample file, captured up front so the
+    // worker threads never have to touch the value tree.
+    struct SampleRenderJob {
+        juce::ValueTree valueTree;
+        juce::File sampleFile;
+        juce::File outputFile;
+        juce::String outputPath;
+        bool simpleCopy = false;
+        int start = 0;
+        int end = -1;
+        bool loopEnabled = false;
+        int loopStart = 0;
+        int loopEnd = -1;
+        int loopCrossfade = 0;
+        juce::String loopCrossfadeMode;
+        int overrideBitrate = 0;
+        juce::MemoryBlock sourceData;
+        juce::MemoryBlock outputData;
+        DSZipWriter::PreparedEntry archiveEntry;
+        bool succeeded = false;
+        juce::String errorMessage;
+    };
+    
+    // The generic effects and UI, parsed once and kept alongside their serialized XML
+    struct GenericUITemplates {
+        GenericUITemplates();
+        juce::ValueTree effects;
+        juce::ValueTree ui;
+        juce::String effectsText;
+        juce::String uiText;
+    };
+    
     juce::ValueTree valueTree;
+    juce::StringArray missingSamplePaths;
+    DSSampleResolver *sampleResolver = nullptr;
+    DSSampleMetadataCache *metadataCache = nullptr;
+    DSZipWriter *outputArchive = nullptr;
+    DSConversionStats *stats = nullptr;
+    DSConversionScheduler *scheduler = nullptr;
+    std::unique_ptr<DSConversionScheduler> ownedScheduler;
+    
+    DSConversionScheduler &getScheduler();
+    bool renderSample(SampleRenderJob &job);
+    bool readSampleData(const juce::File &sampleFile, juce::MemoryBlock &data, DSSampleIO &sampleIO);
+    static std::unique_ptr<juce::AudioFormat> createAudioFormatForFile(const juce::File &sampleFile);
+    static DSZipWriter::Compression getArchiveCompressionForFile(const juce::File &sampleFile);
+    static bool sampleFileExists(const juce::File &sampleFile);
     void translateSFZRegionProperties(juce::ValueTree sfzRegion, juce::ValueTree &dsSample, HeaderLevel level);
     void addGenericUI();
-
-    double linearOrDbStringToDb(const juce::String inputString);
+    static const GenericUITemplates &getGenericUITemplates();
+    static void writeXMLElement(juce::OutputStream &output, const juce::ValueTree &element, int depth);
 };
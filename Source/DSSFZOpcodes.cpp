@@ -0,0 +1,244 @@
+/*
+  ==============================================================================
+
+    DSSFZOpcodes.cpp
+    Created: 19 Oct 2026 1:05:52pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSSFZOpcodes.h"
+
+// In the order getSFZ writes them out
+static constexpr DSSFZOpcodes::Opcode opcodeTable[] = {
+    { "group_label",     "name",             DSSFZOpcodes::conversionCopy,                 true,  true  },
+    { "sample",          "path",             DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "pitch_keycenter", "rootNote",         DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "lokey",           "loNote",           DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "hikey",           "hiNote",           DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "lovel",           "loVel",            DSSFZOpcodes::conversionLowVelocity,          false, true  },
+    { "hivel",           "hiVel",            DSSFZOpcodes::conversionHighVelocity,         false, true  },
+    { "offset",          "start",            DSSFZOpcodes::conversionOffset,               false, true  },
+    { "end",             "end",              DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "loop_mode",       "loopEnabled",      DSSFZOpcodes::conversionLoopMode,             false, true  },
+    { "loop_start",      "loopStart",        DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "loop_end",        "loopEnd",          DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "pan",             "pan",              DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "amp_veltrack",    "ampVelTrack",      DSSFZOpcodes::conversionPercentToFraction,    false, true  },
+    { "ampeg_attack",    "attack",           DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "ampeg_release",   "release",          DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "ampeg_sustain",   "sustain",          DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "ampeg_decay",     "decay",            DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "seq_position",    "seqPosition",      DSSFZOpcodes::conversionSequence,             false, true  },
+    { "seq_length",      "seqLength",        DSSFZOpcodes::conversionSequence,             false, true  },
+    { "group",           "tags",             DSSFZOpcodes::conversionVoiceGroupTag,        false, true  },
+    { "off_by",          "silencedByTags",   DSSFZOpcodes::conversionSilencingVoiceGroup,  false, true  },
+    { "off_mode",        "silencingMode",    DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "sw_previous",     "previousNote",     DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "trigger",         "trigger",          DSSFZOpcodes::conversionCopy,                 false, true  },
+    { "tune",            "tuning",           DSSFZOpcodes::conversionCentsToSemitones,     false, true  },
+    { "volume",          "volume",           DSSFZOpcodes::conversionDecibels,             false, true  },
+    { "key",             nullptr,            DSSFZOpcodes::conversionKey,                  false, false }
+};
+
+static constexpr int numOpcodes = (int) (sizeof(opcodeTable) / sizeof(opcodeTable[0]));
+
+//==============================================================================
+// The perfect hash: a seeded FNV-1a hash into a table of hashSlotCount slots. The seed
+// is searched for at compile time so that no two opcodes share a slot, which means a
+// lookup is one hash, one slot read and one string compare.
+
+static constexpr int hashSlotCount = 128;
+
+static constexpr juce::uint32 hashOpcodeName(const char *name, size_t length, juce::uint32 seed) {
+    juce::uint32 hash = 2166136261u ^ seed;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (juce::uint8) name[i];
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+static constexpr size_t constexprLength(const char *text) {
+    size_t length = 0;
+    while(text[length] != 0) {
+        length++;
+    }
+    return length;
+}
+
+static constexpr int getSlot(const char *name, size_t length, juce::uint32 seed) {
+    return (int) (hashOpcodeName(name, length, seed) % (juce::uint32) hashSlotCount);
+}
+
+static constexpr bool seedHasNoCollisions(juce::uint32 seed) {
+    bool used[hashSlotCount] = {};
+    for (int i = 0; i < numOpcodes; i++) {
+        int slot = getSlot(opcodeTable[i].sfzName, constexprLength(opcodeTable[i].sfzName), seed);
+        if(used[slot]) {
+            return false;
+        }
+        used[slot] = true;
+    }
+    return true;
+}
+
+static constexpr juce::uint32 findPerfectSeed() {
+    for (juce::uint32 seed = 0; seed < 100000; seed++) {
+        if(seedHasNoCollisions(seed)) {
+            return seed;
+        }
+    }
+    return 0xFFFFFFFF;
+}
+
+static constexpr juce::uint32 perfectSeed = findPerfectSeed();
+static_assert(perfectSeed != 0xFFFFFFFF, "No collision-free seed found; raise hashSlotCount.");
+
+struct DSSFZOpcodeSlots {
+    signed char indexes[hashSlotCount];
+};
+
+static constexpr DSSFZOpcodeSlots buildSlots() {
+    DSSFZOpcodeSlots slots {};
+    for (int i = 0; i < hashSlotCount; i++) {
+        slots.indexes[i] = -1;
+    }
+    for (int i = 0; i < numOpcodes; i++) {
+        slots.indexes[getSlot(opcodeTable[i].sfzName, constexprLength(opcodeTable[i].sfzName), perfectSeed)] = (signed char) i;
+    }
+    return slots;
+}
+
+static constexpr DSSFZOpcodeSlots opcodeSlots = buildSlots();
+
+//==============================================================================
+const DSSFZOpcodes::Opcode *DSSFZOpcodes::find(const juce::String &sfzName) {
+    const char *name = sfzName.toRawUTF8();
+    size_t length = sfzName.getNumBytesAsUTF8();
+    int index = opcodeSlots.indexes[getSlot(name, length, perfectSeed)];
+    if(index < 0) {
+        return nullptr;
+    }
+    const Opcode &opcode = opcodeTable[index];
+    if(constexprLength(opcode.sfzName) != length || memcmp(opcode.sfzName, name, length) != 0) {
+        return nullptr;
+    }
+    return &opcode;
+}
+
+int DSSFZOpcodes::getNumOpcodes() {
+    return numOpcodes;
+}
+
+const DSSFZOpcodes::Opcode &DSSFZOpcodes::getOpcode(int index) {
+    return opcodeTable[index];
+}
+
+void DSSFZOpcodes::applyToDecentSampler(const Opcode &opcode, const juce::var &value, juce::ValueTree &dsEntity) {
+    switch (opcode.conversion) {
+        case conversionPercentToFraction:
+            dsEntity.setProperty(opcode.dsProperty, ((float)value)/100.0f, nullptr);
+            break;
+        case conversionVoiceGroupTag:
+        case conversionSilencingVoiceGroup:
+            dsEntity.setProperty(opcode.dsProperty, "voice-group-" + value.toString(), nullptr);
+            break;
+        case conversionLoopMode:
+            if(value == "loop_continuous") {
+                dsEntity.setProperty(opcode.dsProperty, "true", nullptr);
+            }
+            break;
+        case conversionKey:
+            dsEntity.setProperty("rootNote", value, nullptr);
+            dsEntity.setProperty("loNote", value, nullptr);
+            dsEntity.setProperty("hiNote", value, nullptr);
+            break;
+        case conversionSequence:
+            dsEntity.setProperty(opcode.dsProperty, value, nullptr);
+            dsEntity.setProperty("seqMode", "round_robin", nullptr);
+            break;
+        case conversionCentsToSemitones:
+            dsEntity.setProperty(opcode.dsProperty, ((int)value)/100.0, nullptr);
+            break;
+        case conversionDecibels:
+            dsEntity.setProperty(opcode.dsProperty, value.toString() + "dB", nullptr);
+            break;
+        case conversionCopy:
+        case conversionLowVelocity:
+        case conversionHighVelocity:
+        case conversionOffset:
+        default:
+            dsEntity.setProperty(opcode.dsProperty, value, nullptr);
+            break;
+    }
+}
+
+bool DSSFZOpcodes::getSFZValue(const Opcode &opcode, const juce::ValueTree &dsEntity, juce::String &value) {
+    if(!opcode.emitToSFZ || opcode.dsProperty == nullptr || !dsEntity.hasProperty(opcode.dsProperty)) {
+        return false;
+    }
+    juce::var property = dsEntity.getProperty(opcode.dsProperty);
+    
+    switch (opcode.conversion) {
+        case conversionLowVelocity:
+            value = property.toString();
+            return value != "0";
+        case conversionHighVelocity:
+            value = property.toString();
+            return value != "127";
+        case conversionOffset:
+            value = property.toString();
+            return value != "0";
+        case conversionLoopMode:
+            value = "loop_continuous";
+            return true;
+        case conversionPercentToFraction: {
+            if(property == "1.0") {
+                return false;
+            }
+            float fraction = property;
+            if(fraction >= 0 && fraction < 1) {
+                value = juce::String((int)(fraction*100));
+                return true;
+            }
+            return false;
+        }
+        case conversionVoiceGroupTag:
+            // Only the tags that came from SFZ voice groups can be turned back into them
+            if(!property.toString().contains("voice-group-")) {
+                return false;
+            }
+            value = property.toString().replace("voice-group-", "");
+            return true;
+        case conversionSilencingVoiceGroup:
+            value = property.toString().replace("voice-group-", "");
+            return true;
+        case conversionCentsToSemitones:
+            value = juce::String((int)((float)property * 100.0f));
+            return true;
+        case conversionDecibels:
+            value = juce::String(linearOrDbStringToDb(property.toString()));
+            return true;
+        case conversionKey:
+            return false;
+        case conversionCopy:
+        case conversionSequence:
+        default:
+            value = property.toString();
+            return true;
+    }
+}
+
+double DSSFZOpcodes::linearOrDbStringToDb(const juce::String inputString) {
+    if (inputString.contains("dB")) {
+        return juce::jlimit(
+             (double) -100,
+             (double) 24,
+             inputString.upToFirstOccurrenceOf("dB", false, true).getDoubleValue());
+        
+    } else {
+        return juce::Decibels::gainToDecibels(inputString.getDoubleValue());
+    }
+}
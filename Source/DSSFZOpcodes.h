@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    DSSFZOpcodes.h
+    Created: 19 Oct 2026 1:05:52pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// The single table of SFZ opcodes that we know how to map to DecentSampler properties.
+// It drives both directions of the conversion: translateSFZRegionProperties looks
+// opcodes up by name (through a perfect hash that is built from the table at compile
+// time), and getSFZ walks the table in order to emit them, so the two can't drift apart.
+class DSSFZOpcodes {
+public:
+    enum Conversion {
+        conversionCopy,                 // the value is used as is
+        conversionPercentToFraction,    // amp_veltrack 0-100 <-> ampVelTrack 0-1
+        conversionVoiceGroupTag,        // group N <-> tags "voice-group-N"
+        conversionSilencingVoiceGroup,  // off_by N <-> silencedByTags "voice-group-N"
+        conversionLoopMode,             // loop_mode=loop_continuous <-> loopEnabled
+        conversionKey,                  // key sets rootNote, loNote and hiNote
+        conversionSequence,             // seq_* also switch the round robin mode on
+        conversionCentsToSemitones,     // tune <-> tuning
+        conversionDecibels,             // volume in dB <-> volume as "NdB" or linear gain
+        conversionLowVelocity,          // lovel is omitted when it is 0
+        conversionHighVelocity,         // hivel is omitted when it is 127
+        conversionOffset                // offset is omitted when it is 0
+    };
+    
+    struct Opcode {
+        const char *sfzName;
+        const char *dsProperty;         // nullptr for opcodes that only convert one way
+        Conversion conversion;
+        bool groupOnly;                 // only valid on a <group> header
+        bool emitToSFZ;                 // false for opcodes that getSFZ never writes
+    };
+    
+    // Returns nullptr for opcodes that aren't in the table
+    static const Opcode *find(const juce::String &sfzName);
+    
+    static int getNumOpcodes();
+    static const Opcode &getOpcode(int index);
+    
+    // SFZ -> DecentSampler
+    static void applyToDecentSampler(const Opcode &opcode, const juce::var &value, juce::ValueTree &dsEntity);
+    
+    // DecentSampler -> SFZ. Returns false if the entity doesn't produce this opcode.
+    static bool getSFZValue(const Opcode &opcode, const juce::ValueTree &dsEntity, juce::String &value);
+    
+    static double linearOrDbStringToDb(const juce::String inputString);
+};
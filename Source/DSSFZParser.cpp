@@ -0,0 +1,329 @@
+/*
+  ==============================================================================
+
+    DSSFZParser.cpp
+    Created: 19 Oct 2026 9:20:33am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSSFZParser.h"
+
+static const int maxIncludeDepth = 16;
+
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool isIdentifierCharacter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$';
+}
+
+static inline const char *skipToEndOfLine(const char *text, const char *end) {
+    while(text < end && *text != '\n') {
+        text++;
+    }
+    return text;
+}
+
+// Values may contain spaces (sample paths often do), so a value only ends at the end of
+// the line, at a header, at a comment, or at whitespace that is followed by the next
+// "opcode=".
+static const char *findValueEnd(const char *text, const char *end) {
+    while(text < end) {
+        char c = *text;
+        if(c == '\n' || c == '\r' || c == '<') {
+            return text;
+        }
+        if(c == '/' && text + 1 < end && (text[1] == '/' || text[1] == '*')) {
+            return text;
+        }
+        if(c == ' ' || c == '\t') {
+            const char *next = text;
+            while(next < end && (*next == ' ' || *next == '\t')) {
+                next++;
+            }
+            const char *identifierEnd = next;
+            while(identifierEnd < end && isIdentifierCharacter(*identifierEnd)) {
+                identifierEnd++;
+            }
+            if(identifierEnd > next && identifierEnd < end && *identifierEnd == '=') {
+                return text;
+            }
+            text = next;
+            continue;
+        }
+        text++;
+    }
+    return text;
+}
+
+static juce::String makeString(const char *start, const char *end) {
+    return juce::String(juce::CharPointer_UTF8(start), juce::CharPointer_UTF8(end));
+}
+
+bool DSSFZParser::parse(juce::File sfzFile, juce::ValueTree &result) {
+    rootDirectory = sfzFile.getParentDirectory();
+    root = juce::ValueTree("sfz");
+    masterProperties = juce::ValueTree("master");
+    currentGroup = juce::ValueTree();
+    currentRegion = juce::ValueTree();
+    currentHeader = headerNone;
+    defaultPath.clear();
+    defines.clear();
+    numRegions = 0;
+    includedFiles.clear();
+    lastError.clear();
+    
+    if(!parseFile(sfzFile, 0)) {
+        return false;
+    }
+    result = root;
+    return true;
+}
+
+bool DSSFZParser::parseFile(juce::File file, int includeDepth) {
+    if(!file.existsAsFile()) {
+        lastError = "\"" + file.getFullPathName() + "\" is not a file.";
+        return false;
+    }
+    
+    // Mapping fails for empty files, which simply have nothing to parse
+    juce::MemoryMappedFile mappedFile (file, juce::MemoryMappedFile::readOnly);
+    if(mappedFile.getData() == nullptr) {
+        if(file.getSize() == 0) {
+            return true;
+        }
+        lastError = "Unable to open \"" + file.getFullPathName() + "\".";
+        return false;
+    }
+    
+    const char *text = static_cast<const char *>(mappedFile.getData());
+    const char *end = text + mappedFile.getSize();
+    
+    // Skip a UTF-8 byte order mark
+    if(end - text >= 3 && (unsigned char) text[0] == 0xEF && (unsigned char) text[1] == 0xBB && (unsigned char) text[2] == 0xBF) {
+        text += 3;
+    }
+    return parseText(text, end, file, includeDepth);
+}
+
+bool DSSFZParser::parseText(const char *text, const char *end, const juce::File &file, int includeDepth) {
+    while(text < end) {
+        char c = *text;
+        if(isSpace(c)) {
+            text++;
+            continue;
+        }
+        
+        if(c == '/' && text + 1 < end && text[1] == '/') {
+            text = skipToEndOfLine(text, end);
+            continue;
+        }
+        
+        if(c == '/' && text + 1 < end && text[1] == '*') {
+            text += 2;
+            while(text + 1 < end && !(text[0] == '*' && text[1] == '/')) {
+                text++;
+            }
+            text = juce::jmin(text + 2, end);
+            continue;
+        }
+        
+        if(c == '<') {
+            const char *nameStart = text + 1;
+            const char *nameEnd = nameStart;
+            while(nameEnd < end && *nameEnd != '>' && *nameEnd != '\n') {
+                nameEnd++;
+            }
+            if(nameEnd >= end || *nameEnd != '>') {
+                lastError = "Unterminated header in \"" + file.getFullPathName() + "\".";
+                return false;
+            }
+            beginHeader(nameStart, nameEnd);
+            text = nameEnd + 1;
+            continue;
+        }
+        
+        if(c == '#') {
+            text = parseDirective(text, end, file, includeDepth);
+            if(text == nullptr) {
+                return false;
+            }
+            continue;
+        }
+        
+        const char *nameStart = text;
+        while(text < end && *text != '=' && *text != '<' && !isSpace(*text)) {
+            text++;
+        }
+        if(text >= end || *text != '=') {
+            DBG("Skipping stray text \"" + makeString(nameStart, text) + "\" in " + file.getFileName());
+            if(text == nameStart) {
+                text++;
+            }
+            continue;
+        }
+        const char *nameEnd = text;
+        
+        const char *valueStart = text + 1;
+        const char *valueEnd = findValueEnd(valueStart, end);
+        text = valueEnd;
+        while(valueEnd > valueStart && isSpace(valueEnd[-1])) {
+            valueEnd--;
+        }
+        setOpcode(nameStart, nameEnd, valueStart, valueEnd);
+    }
+    return true;
+}
+
+const char *DSSFZParser::parseDirective(const char *text, const char *end, const juce::File &file, int includeDepth) {
+    const char *lineEnd = skipToEndOfLine(text, end);
+    juce::String line = makeString(text, lineEnd).trim();
+    
+    if(line.startsWith("#define")) {
+        juce::String definition = line.substring(7).trim();
+        juce::String name = definition.upToFirstOccurrenceOf(" ", false, false).upToFirstOccurrenceOf("\t", false, false).trim();
+        juce::String value = definition.substring(name.length()).trim();
+        if(name.startsWith("$")) {
+            defines[name] = value;
+        }
+    } else if(line.startsWith("#include")) {
+        juce::String includePath = substituteDefines(line.substring(8).trim().unquoted()).replace("\\", "/");
+        if(includeDepth >= maxIncludeDepth) {
+            lastError = "#include nesting is too deep in \"" + file.getFullPathName() + "\".";
+            return nullptr;
+        }
+        
+        // Includes are relative to the top-level file, but fall back to the including file
+        juce::File includeFile = rootDirectory.getChildFile(includePath);
+        includedFiles.addIfNotAlreadyThere(includeFile);
+        if(!includeFile.existsAsFile()) {
+            includeFile = file.getParentDirectory().getChildFile(includePath);
+            includedFiles.addIfNotAlreadyThere(includeFile);
+        }
+        if(!parseFile(includeFile, includeDepth + 1)) {
+            return nullptr;
+        }
+    } else {
+        DBG("Unsupported directive: " + line);
+    }
+    return lineEnd;
+}
+
+void DSSFZParser::beginHeader(const char *nameStart, const char *nameEnd) {
+    size_t length = (size_t) (nameEnd - nameStart);
+    auto is = [nameStart, length](const char *name) {
+        return strlen(name) == length && memcmp(name, nameStart, length) == 0;
+    };
+    
+    if(is("region")) {
+        currentHeader = headerRegion;
+        if(!currentGroup.isValid()) {
+            // A region that isn't inside a <group> still inherits from the <master>
+            currentGroup = juce::ValueTree("group");
+            currentGroup.copyPropertiesFrom(masterProperties, nullptr);
+            root.appendChild(currentGroup, nullptr);
+        }
+        currentRegion = juce::ValueTree("region");
+        currentGroup.appendChild(currentRegion, nullptr);
+        numRegions++;
+    } else if(is("group")) {
+        currentHeader = headerGroup;
+        currentGroup = juce::ValueTree("group");
+        currentGroup.copyPropertiesFrom(masterProperties, nullptr);
+        root.appendChild(currentGroup, nullptr);
+    } else if(is("master")) {
+        currentHeader = headerMaster;
+        masterProperties = juce::ValueTree("master");
+        currentGroup = juce::ValueTree();
+    } else if(is("global")) {
+        currentHeader = headerGlobal;
+        masterProperties = juce::ValueTree("master");
+        currentGroup = juce::ValueTree();
+    } else if(is("control")) {
+        currentHeader = headerControl;
+    } else {
+        currentHeader = headerOther;
+        DBG("Skipping <" + makeString(nameStart, nameEnd) + "> header");
+    }
+}
+
+void DSSFZParser::setOpcode(const char *nameStart, const char *nameEnd, const char *valueStart, const char *valueEnd) {
+    if(currentHeader == headerOther || currentHeader == headerNone || nameStart == nameEnd) {
+        return;
+    }
+    
+    juce::String value = makeString(valueStart, valueEnd);
+    if(value.containsChar('$')) {
+        value = substituteDefines(value);
+    }
+    
+    juce::Identifier name;
+    if(std::find(nameStart, nameEnd, '$') != nameEnd) {
+        name = substituteDefines(makeString(nameStart, nameEnd));
+    } else {
+        name = juce::Identifier(juce::CharPointer_UTF8(nameStart), juce::CharPointer_UTF8(nameEnd));
+    }
+    
+    static const juce::Identifier sampleOpcode ("sample");
+    static const juce::Identifier defaultPathOpcode ("default_path");
+    
+    if(currentHeader == headerControl) {
+        if(name == defaultPathOpcode) {
+            defaultPath = value.replace("\\", "/");
+        }
+        return;
+    }
+    
+    if(name == sampleOpcode) {
+        value = defaultPath + value.replace("\\", "/");
+    }
+    
+    switch (currentHeader) {
+        case headerGlobal:
+            root.setProperty(name, value, nullptr);
+            break;
+        case headerMaster:
+            masterProperties.setProperty(name, value, nullptr);
+            break;
+        case headerGroup:
+            currentGroup.setProperty(name, value, nullptr);
+            break;
+        case headerRegion:
+            currentRegion.setProperty(name, value, nullptr);
+            break;
+        case headerNone:
+        case headerControl:
+        case headerOther:
+        default:
+            break;
+    }
+}
+
+juce::String DSSFZParser::substituteDefines(const juce::String &text) const {
+    juce::String result;
+    const char *position = text.toRawUTF8();
+    const char *end = position + strlen(position);
+    const char *copiedUpTo = position;
+    
+    while(position < end) {
+        if(*position != '$') {
+            position++;
+            continue;
+        }
+        const char *nameEnd = position + 1;
+        while(nameEnd < end && isIdentifierCharacter(*nameEnd) && *nameEnd != '$') {
+            nameEnd++;
+        }
+        auto found = defines.find(makeString(position, nameEnd));
+        if(found != defines.end()) {
+            result += makeString(copiedUpTo, position) + found->second;
+            copiedUpTo = nameEnd;
+        }
+        position = nameEnd;
+    }
+    result += makeString(copiedUpTo, end);
+    return result;
+}
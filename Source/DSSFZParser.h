@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    DSSFZParser.h
+    Created: 19 Oct 2026 9:20:33am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Reads an .sfz file into the value tree that DSPresetConverter::parseSFZValueTree expects:
+// a root whose properties are the <global> opcodes, with one "group" child per <group>
+// and one "region" child per <region> inside it.
+//
+// The file is memory-mapped and tokenized in place, so the only copies made are the
+// opcode values that end up in the tree. <master> opcodes are folded into each group
+// that follows them, regions that appear outside of a group get a group of their own,
+// the <control> default_path is prepended to every sample, #define'd variables are
+// substituted and #include'd files are parsed inline.
+class DSSFZParser {
+public:
+    DSSFZParser() {}
+    
+    bool parse(juce::File sfzFile, juce::ValueTree &result);
+    
+    juce::String getLastError() const { return lastError; }
+    int getNumRegions() const { return numRegions; }
+    // Every file an #include looked for, whether it was there or not
+    const juce::Array<juce::File> &getIncludedFiles() const { return includedFiles; }
+    
+private:
+    enum Header {
+        headerNone,
+        headerControl,
+        headerGlobal,
+        headerMaster,
+        headerGroup,
+        headerRegion,
+        headerOther
+    };
+    
+    bool parseFile(juce::File file, int includeDepth);
+    bool parseText(const char *text, const char *end, const juce::File &file, int includeDepth);
+    const char *parseDirective(const char *text, const char *end, const juce::File &file, int includeDepth);
+    void beginHeader(const char *nameStart, const char *nameEnd);
+    void setOpcode(const char *nameStart, const char *nameEnd, const char *valueStart, const char *valueEnd);
+    juce::String substituteDefines(const juce::String &text) const;
+    
+    juce::File rootDirectory;
+    juce::ValueTree root;
+    juce::ValueTree masterProperties;
+    juce::ValueTree currentGroup;
+    juce::ValueTree currentRegion;
+    Header currentHeader = headerNone;
+    juce::String defaultPath;
+    std::map<juce::String, juce::String> defines;
+    int numRegions = 0;
+    juce::Array<juce::File> includedFiles;
+    juce::String lastError;
+};
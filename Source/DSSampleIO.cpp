@@ -0,0 +1,691 @@
+/*
+  ==============================================================================
+
+    DSSampleIO.cpp
+    Created: 18 Oct 2026 4:47:18pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSSampleIO.h"
+#include "DSConversionStats.h"
+#include "DSInstrumentation.h"
+#include <cstdio>
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#endif
+
+#if JUCE_LINUX
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <sys/ioctl.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+ #include <linux/fs.h>
+ #include <linux/fiemap.h>
+
+// Reads and writes are done in windows of this size, and each window is dropped from
+// the page cache once it's no longer needed
+static const size_t pageCacheWindowSize = 8 * 1024 * 1024;
+
+static void adviseStreamingRead(int fd) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_NOREUSE);
+}
+
+static void dropReadRange(int fd, off_t offset, off_t length) {
+    posix_fadvise(fd, offset, length, POSIX_FADV_DONTNEED);
+}
+
+// Dirty pages can't be dropped, so wait for the range to reach the disk first
+static void dropWrittenRange(int fd, off_t offset, off_t length) {
+    sync_file_range(fd, offset, length, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+    posix_fadvise(fd, offset, length, POSIX_FADV_DONTNEED);
+}
+
+static void dropWholeWrittenFile(int fd) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+static bool readFully(int fd, char *data, size_t size, off_t offset) {
+    while(size > 0) {
+        ssize_t result = pread(fd, data, size, offset);
+        if(result < 0 && errno == EINTR) {
+            continue;
+        }
+        if(result <= 0) {
+            return false;
+        }
+        data += result;
+        size -= (size_t) result;
+        offset += result;
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const char *data, size_t size, off_t offset) {
+    while(size > 0) {
+        ssize_t result = pwrite(fd, data, size, offset);
+        if(result < 0 && errno == EINTR) {
+            continue;
+        }
+        if(result <= 0) {
+            return false;
+        }
+        data += result;
+        size -= (size_t) result;
+        offset += result;
+    }
+    return true;
+}
+
+// Writes data window by window. Writeback of each window is started as soon as it has
+// been written, and the previous window is waited for and dropped, so the disk always
+// has one window to work on while the next is being filled.
+class DSWriteBehind {
+public:
+    DSWriteBehind(int fd_) : fd(fd_) {}
+    
+    bool write(const char *data, size_t size, off_t offset) {
+        if(!writeFully(fd, data, size, offset)) {
+            return false;
+        }
+        sync_file_range(fd, offset, (off_t) size, SYNC_FILE_RANGE_WRITE);
+        finishPrevious();
+        previousOffset = offset;
+        previousLength = (off_t) size;
+        return true;
+    }
+    
+    void finishPrevious() {
+        if(previousLength > 0) {
+            dropWrittenRange(fd, previousOffset, previousLength);
+            previousLength = 0;
+        }
+    }
+    
+private:
+    int fd;
+    off_t previousOffset = 0;
+    off_t previousLength = 0;
+};
+
+static bool uncachedReadFile(const juce::File &file, juce::MemoryBlock &data) {
+    int fd = open(file.getFullPathName().toRawUTF8(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        return false;
+    }
+    struct stat info;
+    bool succeeded = fstat(fd, &info) == 0;
+    if(succeeded) {
+        adviseStreamingRead(fd);
+        data.setSize((size_t) info.st_size, false);
+        char *destination = static_cast<char *>(data.getData());
+        for (off_t offset = 0; succeeded && offset < info.st_size; offset += (off_t) pageCacheWindowSize) {
+            size_t length = juce::jmin(pageCacheWindowSize, (size_t) (info.st_size - offset));
+            succeeded = readFully(fd, destination + offset, length, offset);
+            dropReadRange(fd, offset, (off_t) length);
+        }
+    }
+    close(fd);
+    return succeeded;
+}
+
+static bool uncachedWriteFile(const juce::File &file, const void *data, size_t size) {
+    int fd = open(file.getFullPathName().toRawUTF8(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        return false;
+    }
+    const char *source = static_cast<const char *>(data);
+    DSWriteBehind writer(fd);
+    bool succeeded = true;
+    for (size_t offset = 0; succeeded && offset < size; offset += pageCacheWindowSize) {
+        succeeded = writer.write(source + offset, juce::jmin(pageCacheWindowSize, size - offset), (off_t) offset);
+    }
+    writer.finishPrevious();
+    close(fd);
+    return succeeded;
+}
+
+static bool uncachedCopyFile(const juce::File &source, const juce::File &destination) {
+    int sourceFd = open(source.getFullPathName().toRawUTF8(), O_RDONLY | O_CLOEXEC);
+    if(sourceFd < 0) {
+        return false;
+    }
+    struct stat info;
+    if(fstat(sourceFd, &info) != 0) {
+        close(sourceFd);
+        return false;
+    }
+    int destinationFd = open(destination.getFullPathName().toRawUTF8(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, info.st_mode & 0777);
+    if(destinationFd < 0) {
+        close(sourceFd);
+        return false;
+    }
+    
+    adviseStreamingRead(sourceFd);
+    juce::HeapBlock<char> buffer (pageCacheWindowSize);
+    DSWriteBehind writer(destinationFd);
+    bool succeeded = true;
+    for (off_t offset = 0; succeeded && offset < info.st_size; offset += (off_t) pageCacheWindowSize) {
+        size_t length = juce::jmin(pageCacheWindowSize, (size_t) (info.st_size - offset));
+        succeeded = readFully(sourceFd, buffer.get(), length, offset)
+                    && writer.write(buffer.get(), length, offset);
+        dropReadRange(sourceFd, offset, (off_t) length);
+    }
+    writer.finishPrevious();
+    close(sourceFd);
+    close(destinationFd);
+    return succeeded;
+}
+#endif
+
+#if DS_USE_IO_URING && JUCE_LINUX
+ #include <liburing.h>
+
+// Each I/O thread gets its own ring so that submissions never need a lock
+class DSIOUring {
+public:
+    static constexpr unsigned queueDepth = 8;
+    static constexpr size_t chunkSize = 256 * 1024;
+    
+    DSIOUring() {
+        if(io_uring_queue_init(queueDepth * 2, &ring, 0) < 0) {
+            return;
+        }
+        ringCreated = true;
+        
+        // A sparse table of two fixed files (source and destination) that is updated per operation
+        int sparseFiles[2] = { -1, -1 };
+        if(io_uring_register_files(&ring, sparseFiles, 2) < 0) {
+            return;
+        }
+        
+        for (unsigned i = 0; i < queueDepth; i++) {
+            void *buffer = nullptr;
+            if(posix_memalign(&buffer, 4096, chunkSize) != 0) {
+                return;
+            }
+            buffers[i].iov_base = buffer;
+            buffers[i].iov_len = chunkSize;
+        }
+        if(io_uring_register_buffers(&ring, buffers, queueDepth) < 0) {
+            return;
+        }
+        ready = true;
+    }
+    
+    ~DSIOUring() {
+        if(ringCreated) {
+            io_uring_queue_exit(&ring);
+        }
+        for (auto &buffer : buffers) {
+            free(buffer.iov_base);
+        }
+    }
+    
+    bool isReady() const { return ready; }
+    
+    // Reads or writes size bytes between fd and memory, keeping up to queueDepth chunks in flight.
+    // The caller's memory is used directly rather than staged through the registered buffers:
+    // that would add a copy of every byte, which costs more than the kernel pinning the pages
+    // of each request, and registering the caller's memory per file would cost more still.
+    bool transfer(int fd, char *data, size_t size, bool isWrite) {
+        bool succeeded = setFixedFiles(fd, -1) && transferChunks(data, size, isWrite);
+        clearFixedFiles();
+        return succeeded;
+    }
+    
+    // Copies between two descriptors through the registered buffers. Each buffer is read
+    // into and then written back out before it is reused for the next chunk.
+    bool copy(int sourceFd, int destinationFd, size_t size) {
+        bool succeeded = setFixedFiles(sourceFd, destinationFd) && copyChunks(size);
+        clearFixedFiles();
+        return succeeded;
+    }
+    
+    static DSIOUring *getForThisThread() {
+        static thread_local std::unique_ptr<DSIOUring> threadRing;
+        if(threadRing == nullptr) {
+            threadRing = std::make_unique<DSIOUring>();
+        }
+        return threadRing->isReady() ? threadRing.get() : nullptr;
+    }
+    
+private:
+    bool transferChunks(char *data, size_t size, bool isWrite) {
+        struct Chunk { size_t offset = 0; size_t length = 0; size_t done = 0; };
+        Chunk chunks[queueDepth];
+        size_t nextOffset = 0;
+        unsigned inFlight = 0;
+        
+        auto submitChunk = [&](unsigned slot) {
+            Chunk &chunk = chunks[slot];
+            io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+            if(isWrite) {
+                io_uring_prep_write(sqe, 0, data + chunk.offset + chunk.done, (unsigned) (chunk.length - chunk.done), chunk.offset + chunk.done);
+            } else {
+                io_uring_prep_read(sqe, 0, data + chunk.offset + chunk.done, (unsigned) (chunk.length - chunk.done), chunk.offset + chunk.done);
+            }
+            io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+            io_uring_sqe_set_data(sqe, (void *) (uintptr_t) slot);
+        };
+        
+        auto startNextChunk = [&](unsigned slot) {
+            if(nextOffset >= size) {
+                return false;
+            }
+            chunks[slot].offset = nextOffset;
+            chunks[slot].length = juce::jmin(chunkSize, size - nextOffset);
+            chunks[slot].done = 0;
+            nextOffset += chunks[slot].length;
+            submitChunk(slot);
+            inFlight++;
+            return true;
+        };
+        
+        for (unsigned slot = 0; slot < queueDepth; slot++) {
+            startNextChunk(slot);
+        }
+        
+        bool succeeded = true;
+        while(inFlight > 0) {
+            if(!submitAndWait()) {
+                abandon(inFlight);
+                return false;
+            }
+            
+            io_uring_cqe *cqe = nullptr;
+            while(io_uring_peek_cqe(&ring, &cqe) == 0 && cqe != nullptr) {
+                unsigned slot = (unsigned) (uintptr_t) io_uring_cqe_get_data(cqe);
+                int result = cqe->res;
+                io_uring_cqe_seen(&ring, cqe);
+                inFlight--;
+                
+                Chunk &chunk = chunks[slot];
+                if(result <= 0) {
+                    // Keep draining the ring so that no completion is left pointing at our memory
+                    succeeded = false;
+                    continue;
+                }
+                chunk.done += (size_t) result;
+                if(!succeeded) {
+                    continue;
+                }
+                if(chunk.done < chunk.length) {
+                    // Short read or write: carry on where it stopped
+                    submitChunk(slot);
+                    inFlight++;
+                } else {
+                    startNextChunk(slot);
+                }
+            }
+        }
+        return succeeded;
+    }
+    
+    bool copyChunks(size_t size) {
+        struct Chunk { size_t offset = 0; size_t length = 0; size_t done = 0; bool writing = false; };
+        Chunk chunks[queueDepth];
+        size_t nextOffset = 0;
+        unsigned inFlight = 0;
+        
+        auto submitChunk = [&](unsigned slot) {
+            Chunk &chunk = chunks[slot];
+            char *buffer = static_cast<char *>(buffers[slot].iov_base) + chunk.done;
+            unsigned length = (unsigned) (chunk.length - chunk.done);
+            io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+            if(chunk.writing) {
+                io_uring_prep_write_fixed(sqe, 1, buffer, length, chunk.offset + chunk.done, (int) slot);
+            } else {
+                io_uring_prep_read_fixed(sqe, 0, buffer, length, chunk.offset + chunk.done, (int) slot);
+            }
+            io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+            io_uring_sqe_set_data(sqe, (void *) (uintptr_t) slot);
+            inFlight++;
+        };
+        
+        auto startNextChunk = [&](unsigned slot) {
+            if(nextOffset >= size) {
+                return;
+            }
+            chunks[slot].offset = nextOffset;
+            chunks[slot].length = juce::jmin(chunkSize, size - nextOffset);
+            chunks[slot].done = 0;
+            chunks[slot].writing = false;
+            nextOffset += chunks[slot].length;
+            submitChunk(slot);
+        };
+        
+        for (unsigned slot = 0; slot < queueDepth; slot++) {
+            startNextChunk(slot);
+        }
+        
+        bool succeeded = true;
+        while(inFlight > 0) {
+            if(!submitAndWait()) {
+                abandon(inFlight);
+                return false;
+            }
+            
+            io_uring_cqe *cqe = nullptr;
+            while(io_uring_peek_cqe(&ring, &cqe) == 0 && cqe != nullptr) {
+                unsigned slot = (unsigned) (uintptr_t) io_uring_cqe_get_data(cqe);
+                int result = cqe->res;
+                io_uring_cqe_seen(&ring, cqe);
+                inFlight--;
+                
+                Chunk &chunk = chunks[slot];
+                if(result <= 0) {
+                    succeeded = false;
+                    continue;
+                }
+                chunk.done += (size_t) result;
+                if(!succeeded) {
+                    continue;
+                }
+                if(chunk.done < chunk.length) {
+                    submitChunk(slot);
+                } else if(!chunk.writing) {
+                    chunk.writing = true;
+                    chunk.done = 0;
+                    submitChunk(slot);
+                } else {
+                    startNextChunk(slot);
+                }
+            }
+        }
+        return succeeded;
+    }
+    
+    // Submits whatever is queued and waits for at least one completion, retrying when
+    // interrupted by a signal or briefly refused.
+    bool submitAndWait() {
+        for (;;) {
+            int result = io_uring_submit_and_wait(&ring, 1);
+            if(result >= 0) {
+                return true;
+            }
+            if(result != -EINTR && result != -EAGAIN) {
+                return false;
+            }
+        }
+    }
+    
+    // Gives up on the ring after a failed submission. Every request the kernel has already
+    // taken is waited for, so no completion is left pointing at our memory once the caller
+    // returns. Requests it never took are still queued and would go out with the next
+    // submission, so the ring is retired and later transfers use the portable path.
+    void abandon(unsigned inFlight) {
+        unsigned submitted = inFlight - juce::jmin(inFlight, io_uring_sq_ready(&ring));
+        while(submitted > 0) {
+            io_uring_cqe *cqe = nullptr;
+            int result = io_uring_wait_cqe(&ring, &cqe);
+            if(result == -EINTR) {
+                continue;
+            }
+            if(result < 0) {
+                break;
+            }
+            io_uring_cqe_seen(&ring, cqe);
+            submitted--;
+        }
+        ready = false;
+    }
+    
+    bool setFixedFiles(int first, int second) {
+        int files[2] = { first, second };
+        return io_uring_register_files_update(&ring, 0, files, 2) == 2;
+    }
+    
+    // The table holds its own reference to each file, which would otherwise keep the last
+    // files transferred open (deleted ones included) until this thread's next transfer
+    void clearFixedFiles() {
+        setFixedFiles(-1, -1);
+    }
+    
+    io_uring ring;
+    iovec buffers[queueDepth] = {};
+    bool ringCreated = false;
+    bool ready = false;
+};
+
+static bool ioUringReadFile(const juce::File &file, juce::MemoryBlock &data, bool keepOutOfPageCache) {
+    DSIOUring *ring = DSIOUring::getForThisThread();
+    int fd = open(file.getFullPathName().toRawUTF8(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        return false;
+    }
+    struct stat info;
+    bool succeeded = fstat(fd, &info) == 0;
+    if(succeeded) {
+        if(keepOutOfPageCache) {
+            adviseStreamingRead(fd);
+        }
+        data.setSize((size_t) info.st_size, false);
+        succeeded = ring->transfer(fd, static_cast<char *>(data.getData()), (size_t) info.st_size, false);
+        if(keepOutOfPageCache) {
+            dropReadRange(fd, 0, 0);
+        }
+    }
+    close(fd);
+    return succeeded;
+}
+
+static bool ioUringWriteFile(const juce::File &file, const void *data, size_t size, bool keepOutOfPageCache) {
+    DSIOUring *ring = DSIOUring::getForThisThread();
+    int fd = open(file.getFullPathName().toRawUTF8(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        return false;
+    }
+    bool succeeded = ring->transfer(fd, const_cast<char *>(static_cast<const char *>(data)), size, true);
+    if(keepOutOfPageCache) {
+        dropWholeWrittenFile(fd);
+    }
+    close(fd);
+    return succeeded;
+}
+
+static bool ioUringCopyFile(const juce::File &source, const juce::File &destination, bool keepOutOfPageCache) {
+    DSIOUring *ring = DSIOUring::getForThisThread();
+    int sourceFd = open(source.getFullPathName().toRawUTF8(), O_RDONLY | O_CLOEXEC);
+    if(sourceFd < 0) {
+        return false;
+    }
+    struct stat info;
+    if(fstat(sourceFd, &info) != 0) {
+        close(sourceFd);
+        return false;
+    }
+    int destinationFd = open(destination.getFullPathName().toRawUTF8(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, info.st_mode & 0777);
+    if(destinationFd < 0) {
+        close(sourceFd);
+        return false;
+    }
+    if(keepOutOfPageCache) {
+        adviseStreamingRead(sourceFd);
+    }
+    bool succeeded = ring->copy(sourceFd, destinationFd, (size_t) info.st_size);
+    if(keepOutOfPageCache) {
+        dropReadRange(sourceFd, 0, 0);
+        dropWholeWrittenFile(destinationFd);
+    }
+    close(sourceFd);
+    close(destinationFd);
+    return succeeded;
+}
+#endif
+
+DSSampleIO::DSSampleIO(Backend preferredBackend) {
+    backend = preferredBackend;
+    if(backend == backendAuto) {
+        backend = isIOUringAvailable() ? backendIOUring : backendStreams;
+    } else if(backend == backendIOUring && !isIOUringAvailable()) {
+        std::cerr << "io_uring is not available, falling back to regular file streams." << std::endl;
+        backend = backendStreams;
+    }
+}
+
+bool DSSampleIO::parseBackendName(const juce::String &name, Backend &backend) {
+    if(name == "auto") {
+        backend = backendAuto;
+    } else if(name == "streams") {
+        backend = backendStreams;
+    } else if(name == "io_uring") {
+        backend = backendIOUring;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool DSSampleIO::isIOUringAvailable() {
+#if DS_USE_IO_URING && JUCE_LINUX
+    // Creating a ring is the only reliable probe: the syscall may be missing or blocked
+    static const bool available = DSIOUring::getForThisThread() != nullptr;
+    return available;
+#else
+    return false;
+#endif
+}
+
+juce::String DSSampleIO::getBackendName() const {
+    return backend == backendIOUring ? "io_uring" : "streams";
+}
+
+bool DSSampleIO::readFile(const juce::File &file, juce::MemoryBlock &data) {
+    DS_INSTRUMENT_SCOPE ("io.readFile");
+    if(!readFileWithBackend(file, data)) {
+        return false;
+    }
+    DSConversionStats::count(DSConversionStats::counterBytesRead, (juce::int64) data.getSize());
+    DS_INSTRUMENT_HISTOGRAM ("io.sampleBytes", data.getSize());
+    return true;
+}
+
+bool DSSampleIO::readFileWithBackend(const juce::File &file, juce::MemoryBlock &data) {
+#if DS_USE_IO_URING && JUCE_LINUX
+    if(backend == backendIOUring && DSIOUring::getForThisThread() != nullptr) {
+        return ioUringReadFile(file, data, keepOutOfPageCache);
+    }
+#endif
+#if JUCE_LINUX
+    if(keepOutOfPageCache) {
+        return uncachedReadFile(file, data);
+    }
+#endif
+    return file.loadFileAsData(data);
+}
+
+bool DSSampleIO::writeFile(const juce::File &file, const void *data, size_t size) {
+    DS_INSTRUMENT_SCOPE ("io.writeFile");
+    if(!writeFileWithBackend(file, data, size)) {
+        return false;
+    }
+    DSConversionStats::count(DSConversionStats::counterBytesWritten, (juce::int64) size);
+    return true;
+}
+
+bool DSSampleIO::writeFileWithBackend(const juce::File &file, const void *data, size_t size) {
+#if DS_USE_IO_URING && JUCE_LINUX
+    if(backend == backendIOUring && DSIOUring::getForThisThread() != nullptr) {
+        return ioUringWriteFile(file, data, size, keepOutOfPageCache);
+    }
+#endif
+#if JUCE_LINUX
+    if(keepOutOfPageCache) {
+        return uncachedWriteFile(file, data, size);
+    }
+#endif
+    return file.replaceWithData(data, size);
+}
+
+bool DSSampleIO::copyFile(const juce::File &source, const juce::File &destination) {
+    DS_INSTRUMENT_SCOPE ("io.copyFile");
+    if(!copyFileWithBackend(source, destination)) {
+        return false;
+    }
+    // Finding out how much was copied costs a stat, so only do it when someone is counting
+    if(DSConversionStats::isCounting()) {
+        juce::int64 size = destination.getSize();
+        DSConversionStats::count(DSConversionStats::counterFilesStatted);
+        DSConversionStats::count(DSConversionStats::counterBytesRead, size);
+        DSConversionStats::count(DSConversionStats::counterBytesWritten, size);
+    }
+    return true;
+}
+
+bool DSSampleIO::copyFileWithBackend(const juce::File &source, const juce::File &destination) {
+#if DS_USE_IO_URING && JUCE_LINUX
+    if(backend == backendIOUring && DSIOUring::getForThisThread() != nullptr) {
+        return ioUringCopyFile(source, destination, keepOutOfPageCache);
+    }
+#endif
+#if JUCE_LINUX
+    if(keepOutOfPageCache) {
+        return uncachedCopyFile(source, destination);
+    }
+#endif
+    return source.copyFileTo(destination);
+}
+
+juce::int64 DSSampleIO::getPhysicalOffset(const juce::File &file) {
+#if JUCE_LINUX
+    int fd = open(file.getFullPathName().toRawUTF8(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        return -1;
+    }
+    
+    // Room for the header and a single extent; only the first one matters
+    alignas(struct fiemap) char buffer[sizeof(struct fiemap) + sizeof(struct fiemap_extent)] = {};
+    auto *extentMap = reinterpret_cast<struct fiemap *>(buffer);
+    extentMap->fm_start = 0;
+    extentMap->fm_length = FIEMAP_MAX_OFFSET;
+    extentMap->fm_extent_count = 1;
+    
+    juce::int64 offset = -1;
+    if(ioctl(fd, FS_IOC_FIEMAP, extentMap) == 0 && extentMap->fm_mapped_extents > 0) {
+        offset = (juce::int64) extentMap->fm_extents[0].fe_physical;
+    }
+    close(fd);
+    return offset;
+#else
+    juce::ignoreUnused(file);
+    return -1;
+#endif
+}
+
+juce::Array<int> DSSampleIO::getPhysicalReadOrder(const juce::Array<juce::File> &files) {
+    // The same sample is often used by many zones, so only ask once per file
+    std::map<juce::String, juce::int64> offsetsByPath;
+    juce::Array<juce::int64> offsets;
+    for (auto &file : files) {
+        juce::String path = file.getFullPathName();
+        auto found = offsetsByPath.find(path);
+        if(found == offsetsByPath.end()) {
+            juce::int64 offset = getPhysicalOffset(file);
+            found = offsetsByPath.emplace(path, offset < 0 ? std::numeric_limits<juce::int64>::max() : offset).first;
+        }
+        offsets.add(found->second);
+    }
+    
+    juce::Array<int> order;
+    for (int i = 0; i < files.size(); i++) {
+        order.add(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&offsets](int a, int b) {
+        return offsets[a] < offsets[b];
+    });
+    return order;
+}
+
+bool DSSampleIO::replaceFile(const juce::File &replacement, const juce::File &target) {
+#if JUCE_WINDOWS
+    return MoveFileExW(replacement.getFullPathName().toWideCharPointer(), target.getFullPathName().toWideCharPointer(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(replacement.getFullPathName().toRawUTF8(), target.getFullPathName().toRawUTF8()) == 0;
+#endif
+}
@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    DSSampleIO.h
+    Created: 18 Oct 2026 4:47:18pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Set DS_USE_IO_URING=1 in the project's preprocessor definitions (and link against
+// liburing) to build the Linux io_uring backend.
+#ifndef DS_USE_IO_URING
+ #define DS_USE_IO_URING 0
+#endif
+
+// Whole-file reads, writes and copies for the sample pipeline. By default these go
+// through the JUCE streams. On Linux the io_uring backend batches the reads and writes
+// of a file into a single ring (using fixed files, and registered buffers for copies)
+// to keep a deeper queue with far fewer syscalls. If a ring can't be created, for
+// example on an older kernel or inside a restrictive sandbox, it falls back to the
+// JUCE streams.
+class DSSampleIO {
+public:
+    enum Backend {
+        backendAuto,
+        backendStreams,
+        backendIOUring
+    };
+    
+    DSSampleIO(Backend preferredBackend = backendAuto);
+    
+    // Returns false if the name isn't recognised.
+    static bool parseBackendName(const juce::String &name, Backend &backend);
+    static bool isIOUringAvailable();
+    
+    Backend getBackend() const { return backend; }
+    juce::String getBackendName() const;
+    
+    // When set, reads are advised as sequential/no-reuse and everything read or written is
+    // dropped from the page cache as the transfer goes, so that migrating a huge library
+    // doesn't evict the cache of everything else running on the host. Written data is
+    // flushed to disk first, since dirty pages can't be dropped. Linux only; elsewhere
+    // this has no effect. Set it before any I/O starts.
+    void setKeepOutOfPageCache(bool shouldKeepOutOfPageCache) { keepOutOfPageCache = shouldKeepOutOfPageCache; }
+    bool isKeepingOutOfPageCache() const { return keepOutOfPageCache; }
+    
+    // When set, the pipeline reads its source files in the order they're laid out on disk
+    // rather than in region order, which turns the copy stage into mostly sequential I/O
+    // on spinning disks. Works best with a single I/O thread.
+    void setReadInPhysicalOrder(bool shouldReadInPhysicalOrder) { readInPhysicalOrder = shouldReadInPhysicalOrder; }
+    bool isReadingInPhysicalOrder() const { return readInPhysicalOrder; }
+    
+    // The physical byte offset of the first extent of a file (via FIEMAP on Linux), or -1
+    // if it can't be determined.
+    static juce::int64 getPhysicalOffset(const juce::File &file);
+    
+    // The indexes of files, sorted by their physical location. Files whose location is
+    // unknown keep their relative order and come last.
+    static juce::Array<int> getPhysicalReadOrder(const juce::Array<juce::File> &files);
+    
+    // Renames replacement over target in a single step, so that anything reading target sees
+    // either the old file or the new one and never neither. Both must be on the same volume.
+    static bool replaceFile(const juce::File &replacement, const juce::File &target);
+    
+    // All of these are safe to call from several threads at once.
+    bool readFile(const juce::File &file, juce::MemoryBlock &data);
+    bool writeFile(const juce::File &file, const void *data, size_t size);
+    bool copyFile(const juce::File &source, const juce::File &destination);
+    
+private:
+    bool readFileWithBackend(const juce::File &file, juce::MemoryBlock &data);
+    bool writeFileWithBackend(const juce::File &file, const void *data, size_t size);
+    bool copyFileWithBackend(const juce::File &source, const juce::File &destination);
+
+    Backend backend;
+    bool keepOutOfPageCache = false;
+    bool readInPhysicalOrder = false;
+};
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    DSSampleMetadataCache.cpp
+    Created: 18 Oct 2026 8:03:14pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSSampleMetadataCache.h"
+#include "DSConversionStats.h"
+
+bool DSSampleMetadataCache::getSampleRate(const juce::File &file, double &sampleRate) {
+    Entry entry;
+    {
+        const juce::ScopedLock scopedLock(lock);
+        auto found = entries.find(file.getFullPathName());
+        if(found == entries.end()) {
+            return false;
+        }
+        entry = found->second;
+    }
+    
+    DSConversionStats::count(DSConversionStats::counterFilesStatted, 2);
+    if(entry.size != file.getSize() || entry.modificationTime != file.getLastModificationTime()) {
+        return false;
+    }
+    sampleRate = entry.sampleRate;
+    return true;
+}
+
+void DSSampleMetadataCache::setSampleRate(const juce::File &file, double sampleRate) {
+    Entry entry;
+    DSConversionStats::count(DSConversionStats::counterFilesStatted, 2);
+    entry.size = file.getSize();
+    entry.modificationTime = file.getLastModificationTime();
+    entry.sampleRate = sampleRate;
+    
+    const juce::ScopedLock scopedLock(lock);
+    entries[file.getFullPathName()] = entry;
+}
+
+void DSSampleMetadataCache::clear() {
+    const juce::ScopedLock scopedLock(lock);
+    entries.clear();
+}
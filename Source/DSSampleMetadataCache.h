@@ -0,0 +1,33 @@
+/*
+  ==============================================================================
+
+    DSSampleMetadataCache.h
+    Created: 18 Oct 2026 8:03:14pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+
+// Remembers what was learnt from opening a sample file's header, keyed by path and
+// invalidated when the file's size or modification time changes. Thread-safe.
+class DSSampleMetadataCache {
+public:
+    bool getSampleRate(const juce::File &file, double &sampleRate);
+    void setSampleRate(const juce::File &file, double sampleRate);
+    void clear();
+    
+private:
+    struct Entry {
+        juce::int64 size = 0;
+        juce::Time modificationTime;
+        double sampleRate = 0;
+    };
+    
+    juce::CriticalSection lock;
+    std::map<juce::String, Entry> entries;
+};
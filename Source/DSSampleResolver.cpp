@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    DSSampleResolver.cpp
+    Created: 18 Oct 2026 6:12:40pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSSampleResolver.h"
+
+juce::String DSFileSampleResolver::resolveSample(const juce::String &path, const juce::String &sampleSetName) {
+    for (auto &sampleFile : getCandidateFiles(path, sampleSetName)) {
+        if(fileExists(sampleFile)) {
+            return sampleFile.getFullPathName();
+        }
+    }
+    return juce::String();
+}
+
+juce::Array<juce::File> DSFileSampleResolver::getCandidateFiles(const juce::String &path, const juce::String &sampleSetName) const {
+    return {
+        juce::File::getCurrentWorkingDirectory().getChildFile(path),
+        inputDirectory.getChildFile(sampleSetName).getChildFile(path),
+        inputDirectory.getChildFile("Samples").getChildFile(path)
+    };
+}
+
+std::unique_ptr<juce::InputStream> DSFileSampleResolver::openSample(const juce::String &resolvedPath) {
+    std::unique_ptr<juce::FileInputStream> inputStream = juce::File(resolvedPath).createInputStream();
+    if(inputStream == nullptr) {
+        return nullptr;
+    }
+    return inputStream;
+}
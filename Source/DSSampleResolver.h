@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    DSSampleResolver.h
+    Created: 18 Oct 2026 6:12:40pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DSDirectoryIndex.h"
+#include "DSConversionStats.h"
+
+// Finds and opens the samples an instrument refers to. The converter only goes through
+// this interface, so instruments can be converted against something other than the local
+// file system. Implementations are called from the scheduler's I/O threads and must be
+// thread-safe.
+class DSSampleResolver {
+public:
+    virtual ~DSSampleResolver() {}
+    
+    // Looks up a sample path as written in the instrument. Returns the path that should be
+    // stored in the converted preset, or an empty string if the sample can't be found.
+    virtual juce::String resolveSample(const juce::String &path, const juce::String &sampleSetName) = 0;
+    
+    // Opens a path returned by resolveSample, or returns nullptr.
+    virtual std::unique_ptr<juce::InputStream> openSample(const juce::String &resolvedPath) = 0;
+};
+
+// Resolves samples on the local file system, the same way the command line tool always has:
+// as given, then in <inputDirectory>/<sampleSetName>/ and then in <inputDirectory>/Samples/.
+// Resolved paths are absolute. If an index is given, lookups are answered from it instead
+// of going to the file system every time.
+class DSFileSampleResolver : public DSSampleResolver {
+public:
+    DSFileSampleResolver(juce::File inputDirectory, DSDirectoryIndex *directoryIndex = nullptr)
+        : inputDirectory(inputDirectory), directoryIndex(directoryIndex) {}
+    
+    juce::String resolveSample(const juce::String &path, const juce::String &sampleSetName) override;
+    std::unique_ptr<juce::InputStream> openSample(const juce::String &resolvedPath) override;
+    
+    // The places resolveSample looks for a sample, in order
+    juce::Array<juce::File> getCandidateFiles(const juce::String &path, const juce::String &sampleSetName) const;
+    
+private:
+    bool fileExists(const juce::File &file) {
+        if(directoryIndex != nullptr) {
+            return directoryIndex->fileExists(file);
+        }
+        DSConversionStats::count(DSConversionStats::counterFilesStatted);
+        return file.existsAsFile();
+    }
+    
+    juce::File inputDirectory;
+    DSDirectoryIndex *directoryIndex;
+};
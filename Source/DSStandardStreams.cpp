@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    DSStandardStreams.cpp
+    Created: 18 Oct 2026 7:25:51pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSStandardStreams.h"
+#include <cstdio>
+
+#if JUCE_WINDOWS
+ #include <fcntl.h>
+ #include <io.h>
+#endif
+
+// Without this Windows would translate line endings in the binary data
+static void setBinaryMode(FILE *file) {
+#if JUCE_WINDOWS
+    _setmode(_fileno(file), _O_BINARY);
+#else
+    juce::ignoreUnused(file);
+#endif
+}
+
+void DSStandardStreams::sendInfoToStandardError() {
+    std::cout.flush();
+    std::cout.rdbuf(std::cerr.rdbuf());
+}
+
+bool DSStandardStreams::readAll(juce::MemoryBlock &data) {
+    setBinaryMode(stdin);
+    data.reset();
+    
+    char buffer[65536];
+    for (;;) {
+        size_t numRead = fread(buffer, 1, sizeof(buffer), stdin);
+        if(numRead > 0) {
+            data.append(buffer, numRead);
+        }
+        if(numRead < sizeof(buffer)) {
+            return ferror(stdin) == 0;
+        }
+    }
+}
+
+bool DSStandardStreams::readExactly(void *destination, size_t numBytes) {
+    setBinaryMode(stdin);
+    return fread(destination, 1, numBytes, stdin) == numBytes;
+}
+
+DSStandardStreams::Output::Output() {
+    setBinaryMode(stdout);
+}
+
+void DSStandardStreams::Output::flush() {
+    fflush(stdout);
+}
+
+bool DSStandardStreams::Output::write(const void *data, size_t numBytes) {
+    if(fwrite(data, 1, numBytes, stdout) != numBytes) {
+        return false;
+    }
+    position += (juce::int64) numBytes;
+    return true;
+}
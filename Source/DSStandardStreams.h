@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    DSStandardStreams.h
+    Created: 18 Oct 2026 7:25:51pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Binary access to stdin and stdout for pipeline use, where "-" stands in for a file.
+class DSStandardStreams {
+public:
+    // Once stdout carries converted data, the progress messages written to std::cout
+    // would corrupt it, so they're sent to stderr instead.
+    static void sendInfoToStandardError();
+    
+    // Reads stdin until it's closed.
+    static bool readAll(juce::MemoryBlock &data);
+    // Reads exactly numBytes from stdin. Returns false if stdin ends first.
+    static bool readExactly(void *destination, size_t numBytes);
+    
+    // Writes straight to the process's stdout.
+    class Output : public juce::OutputStream {
+    public:
+        Output();
+        void flush() override;
+        bool setPosition(juce::int64) override { return false; }
+        juce::int64 getPosition() override { return position; }
+        bool write(const void *data, size_t numBytes) override;
+    private:
+        juce::int64 position = 0;
+    };
+};
@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+    DSTrace.cpp
+    Created: 19 Oct 2026 12:36:02am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSTrace.h"
+
+std::atomic<bool> DSTrace::recording { false };
+
+namespace {
+    struct TraceEvent {
+        const char *name;
+        juce::int64 startTicks;
+        juce::int64 durationTicks;
+        // The file name, truncated, as UTF-8
+        char detail[48];
+    };
+
+    // Written only by its own thread. numWritten is published after each event is in place,
+    // so a reader sees complete events once the thread has stopped recording.
+    struct ThreadBuffer {
+        juce::HeapBlock<TraceEvent> events;
+        int capacity = 0;
+        std::atomic<juce::uint64> numWritten { 0 };
+        int threadIndex = 0;
+        const char *threadName = nullptr;
+    };
+
+    struct TraceRegistry {
+        juce::CriticalSection lock;
+        juce::OwnedArray<ThreadBuffer> buffers;
+        int eventsPerThread = 0;
+        juce::int64 startTicks = 0;
+        bool started = false;
+    };
+
+    TraceRegistry &getRegistry() {
+        static TraceRegistry registry;
+        return registry;
+    }
+
+    thread_local ThreadBuffer *threadBuffer = nullptr;
+    thread_local const char *threadName = nullptr;
+
+    ThreadBuffer *getThreadBuffer() {
+        if(threadBuffer == nullptr) {
+            TraceRegistry &registry = getRegistry();
+            const juce::ScopedLock scopedLock(registry.lock);
+            auto *buffer = registry.buffers.add(new ThreadBuffer());
+            buffer->events.malloc((size_t) registry.eventsPerThread);
+            buffer->capacity = registry.eventsPerThread;
+            buffer->threadIndex = registry.buffers.size();
+            buffer->threadName = threadName;
+            threadBuffer = buffer;
+        }
+        return threadBuffer;
+    }
+}
+
+void DSTrace::start(int eventsPerThread) {
+    TraceRegistry &registry = getRegistry();
+    const juce::ScopedLock scopedLock(registry.lock);
+    if(registry.started) {
+        return;
+    }
+    registry.started = true;
+    registry.eventsPerThread = juce::jmax(1, eventsPerThread);
+    registry.startTicks = juce::Time::getHighResolutionTicks();
+    recording.store(true);
+}
+
+void DSTrace::stop() {
+    recording.store(false);
+}
+
+void DSTrace::setCurrentThreadName(const char *name) {
+    threadName = name;
+    if(threadBuffer != nullptr) {
+        threadBuffer->threadName = name;
+    }
+}
+
+DSTrace::ScopedSpan::ScopedSpan(const char *name_) : name(name_) {
+    if(isRecording()) {
+        startTicks = juce::Time::getHighResolutionTicks();
+    }
+}
+
+DSTrace::ScopedSpan::ScopedSpan(const char *name_, const juce::File &file_) : name(name_), file(&file_) {
+    if(isRecording()) {
+        startTicks = juce::Time::getHighResolutionTicks();
+    }
+}
+
+DSTrace::ScopedSpan::~ScopedSpan() {
+    if(startTicks == 0 || !isRecording()) {
+        return;
+    }
+    ThreadBuffer *buffer = getThreadBuffer();
+    juce::uint64 index = buffer->numWritten.load(std::memory_order_relaxed);
+    TraceEvent &event = buffer->events[(size_t) (index % (juce::uint64) buffer->capacity)];
+    event.name = name;
+    event.startTicks = startTicks;
+    event.durationTicks = juce::Time::getHighResolutionTicks() - startTicks;
+    event.detail[0] = 0;
+    if(file != nullptr) {
+        // Taken from the full path, which is already UTF-8, so nothing is allocated. Long
+        // names are cut short.
+        const char *path = file->getFullPathName().toRawUTF8();
+        const char *fileName = path;
+        for (const char *c = path; *c != 0; c++) {
+            if(*c == '/' || *c == '\\') {
+                fileName = c + 1;
+            }
+        }
+        size_t length = juce::jmin(strlen(fileName), sizeof(event.detail) - 1);
+        while (length > 0 && (fileName[length] & 0xc0) == 0x80) {
+            length--;
+        }
+        memcpy(event.detail, fileName, length);
+        event.detail[length] = 0;
+    }
+    buffer->numWritten.store(index + 1, std::memory_order_release);
+}
+
+bool DSTrace::writeJSON(juce::OutputStream &output) {
+    TraceRegistry &registry = getRegistry();
+    const juce::ScopedLock scopedLock(registry.lock);
+
+    auto toMicroseconds = [](juce::int64 ticks) {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+    };
+
+    bool first = true;
+    auto writeEvent = [&output, &first](const juce::var &event) {
+        output.writeText(first ? "\n" : ",\n", false, false, nullptr);
+        output.writeText(juce::JSON::toString(event, true), false, false, nullptr);
+        first = false;
+    };
+
+    output.writeText("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [", false, false, nullptr);
+    for (auto *buffer : registry.buffers) {
+        auto *nameEvent = new juce::DynamicObject();
+        juce::var nameEventVar(nameEvent);
+        nameEvent->setProperty("name", "thread_name");
+        nameEvent->setProperty("ph", "M");
+        nameEvent->setProperty("pid", 1);
+        nameEvent->setProperty("tid", buffer->threadIndex);
+        auto *nameArgs = new juce::DynamicObject();
+        nameArgs->setProperty("name", juce::String(buffer->threadName != nullptr ? buffer->threadName : "Thread") + " " + juce::String(buffer->threadIndex));
+        nameEvent->setProperty("args", juce::var(nameArgs));
+        writeEvent(nameEventVar);
+
+        juce::uint64 numWritten = buffer->numWritten.load(std::memory_order_acquire);
+        juce::uint64 firstIndex = numWritten > (juce::uint64) buffer->capacity ? numWritten - (juce::uint64) buffer->capacity : 0;
+        for (juce::uint64 index = firstIndex; index < numWritten; index++) {
+            const TraceEvent &traceEvent = buffer->events[(size_t) (index % (juce::uint64) buffer->capacity)];
+            auto *event = new juce::DynamicObject();
+            juce::var eventVar(event);
+            event->setProperty("name", traceEvent.name);
+            event->setProperty("cat", "exs2ds");
+            event->setProperty("ph", "X");
+            event->setProperty("ts", toMicroseconds(traceEvent.startTicks - registry.startTicks));
+            event->setProperty("dur", toMicroseconds(traceEvent.durationTicks));
+            event->setProperty("pid", 1);
+            event->setProperty("tid", buffer->threadIndex);
+            if(traceEvent.detail[0] != 0) {
+                auto *args = new juce::DynamicObject();
+                args->setProperty("file", juce::String::fromUTF8(traceEvent.detail));
+                event->setProperty("args", juce::var(args));
+            }
+            writeEvent(eventVar);
+        }
+    }
+    output.writeText("\n]}\n", false, false, nullptr);
+    output.flush();
+    return true;
+}
+
+bool DSTrace::writeJSON(juce::File file) {
+    file.deleteFile();
+    juce::FileOutputStream output(file);
+    if(!output.openedOk()) {
+        std::cerr << "error: could not write \"" << file.getFullPathName() << "\"." << std::endl;
+        return false;
+    }
+    writeJSON(output);
+    if(output.getStatus().failed()) {
+        std::cerr << "error: could not write \"" << file.getFullPathName() << "\"." << std::endl;
+        return false;
+    }
+    return true;
+}
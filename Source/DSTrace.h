@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    DSTrace.h
+    Created: 19 Oct 2026 12:36:02am
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Records timed spans (parse, hunt, probe, read, render, encode, write...) from every thread
+// and writes them out in the Chrome trace-event format, which chrome://tracing and Perfetto
+// open directly.
+//
+// Each thread records into a ring buffer of its own, so recording a span takes no lock and
+// allocates nothing; only a thread's first span registers its buffer. When a buffer is full
+// its oldest spans are overwritten. When recording is off, a span costs one atomic load.
+class DSTrace {
+public:
+    // Starts recording, keeping up to eventsPerThread spans per thread. Only the first call
+    // has any effect; the buffers live until the process exits.
+    static void start(int eventsPerThread = 16384);
+    static void stop();
+    static bool isRecording() { return recording.load(std::memory_order_relaxed); }
+
+    // The name shown for the calling thread, e.g. which pool it belongs to. name must be a
+    // string literal (or otherwise outlive the trace).
+    static void setCurrentThreadName(const char *name);
+
+    // Writes {"traceEvents": [...]} with every span still in the buffers. Threads must not
+    // be recording while this runs, so stop() first (or wait for the conversions to finish).
+    static bool writeJSON(juce::OutputStream &output);
+    static bool writeJSON(juce::File file);
+
+    // Records the time from construction to destruction as a span. name must be a string
+    // literal. The file's name, if given, is shown with the span; the file must outlive it.
+    class ScopedSpan {
+    public:
+        ScopedSpan(const char *name);
+        ScopedSpan(const char *name, const juce::File &file);
+        ~ScopedSpan();
+    private:
+        const char *name;
+        const juce::File *file = nullptr;
+        juce::int64 startTicks = 0;
+        JUCE_DECLARE_NON_COPYABLE (ScopedSpan)
+    };
+
+private:
+    static std::atomic<bool> recording;
+};
@@ -0,0 +1,254 @@
+/*
+  ==============================================================================
+
+    DSWatcher.cpp
+    Created: 18 Oct 2026 9:14:02pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSWatcher.h"
+
+#if JUCE_LINUX
+ #include <poll.h>
+ #include <sys/inotify.h>
+ #include <unistd.h>
+#endif
+
+DSWatcher::DSWatcher(DSBatchConverter &converter_, int debounceMilliseconds_)
+    : converter(converter_),
+      debounceMilliseconds(debounceMilliseconds_) {
+    for (auto &job : converter.getJobs()) {
+        auto *instrument = instruments.add(new WatchedInstrument());
+        instrument->job = job;
+    }
+}
+
+DSWatcher::~DSWatcher() {
+#if JUCE_LINUX
+    if(inotifyHandle >= 0) {
+        close(inotifyHandle);
+    }
+#endif
+}
+
+// The file whose changes mean the instrument has to be parsed again
+juce::File DSWatcher::getSourceFile(const DSConversionJob &job) {
+    return job.archiveFile != juce::File() ? job.archiveFile : job.inputFile;
+}
+
+juce::Array<juce::File> DSWatcher::getInputFiles(const WatchedInstrument &instrument) {
+    juce::Array<juce::File> files { getSourceFile(instrument.job) };
+    files.addArray(instrument.parsed.includedFiles);
+    return files;
+}
+
+juce::Array<juce::File> DSWatcher::getSampleDependencies(const WatchedInstrument &instrument) {
+    // Archived samples change with the archive itself
+    if(instrument.job.archiveFile != juce::File()) {
+        return {};
+    }
+    juce::Array<juce::File> files = instrument.sampleFiles;
+    files.addArray(instrument.missingSampleFiles);
+    return files;
+}
+
+// A file is affected by a change to itself or to any directory above it, since a directory
+// that is created or moved into place brings everything below it along
+bool DSWatcher::isAffected(const juce::File &file, const std::set<juce::String> &changedFiles) {
+    for (juce::File ancestor = file; ; ancestor = ancestor.getParentDirectory()) {
+        if(changedFiles.count(ancestor.getFullPathName()) > 0) {
+            return true;
+        }
+        if(ancestor.getParentDirectory() == ancestor) {
+            return false;
+        }
+    }
+}
+
+bool DSWatcher::isSupported() {
+#if JUCE_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Converts the instruments several at a time. Those whose input is in changedInputs (or
+// that were never parsed) are parsed again first.
+void DSWatcher::convert(juce::Array<WatchedInstrument *> instrumentsToConvert, const std::set<juce::String> &changedInputs) {
+    juce::ThreadPool pool(juce::jmax(1, juce::jmin(converter.getNumConcurrentJobs(), instrumentsToConvert.size())));
+    for (auto *instrument : instrumentsToConvert) {
+        pool.addJob([this, instrument, &changedInputs] {
+            const juce::String inputPath = instrument->job.inputFile.getFullPathName();
+            if(!instrument->isParsed || changedInputs.count(getSourceFile(instrument->job).getFullPathName()) > 0) {
+                instrument->isParsed = converter.parseInput(instrument->job, instrument->parsed);
+                if(!instrument->isParsed) {
+                    std::cerr << "Could not parse \"" << inputPath << "\"; waiting for it to change again." << std::endl;
+                    return;
+                }
+            }
+            
+            if(converter.convert(instrument->job, instrument->parsed, &instrument->sampleFiles, &instrument->missingSampleFiles)) {
+                std::cout << "Converted \"" << inputPath << "\"." << std::endl;
+            } else {
+                std::cerr << "Conversion of \"" << inputPath << "\" failed." << std::endl;
+            }
+        });
+    }
+    while(pool.getNumJobs() > 0) {
+        juce::Thread::sleep(5);
+    }
+}
+
+#if JUCE_LINUX
+
+void DSWatcher::watchDirectory(const juce::File &directory) {
+    for (auto &watched : watchedDirectories) {
+        if(watched.second == directory) {
+            return;
+        }
+    }
+    
+    // Editors often save by writing a temporary file and renaming it over the original.
+    // IN_CREATE catches directories being made for files that aren't there yet.
+    int watchDescriptor = inotify_add_watch(inotifyHandle, directory.getFullPathName().toRawUTF8(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if(watchDescriptor < 0) {
+        std::cerr << "Could not watch \"" << directory.getFullPathName() << "\"." << std::endl;
+        return;
+    }
+    watchedDirectories[watchDescriptor] = directory;
+}
+
+// Watches the directory a file is in, or would be in. Until that directory exists, its
+// nearest existing ancestor is watched instead, but only as far up as boundary.
+void DSWatcher::watchParentDirectory(const juce::File &file, const juce::File &boundary) {
+    juce::File directory = file.getParentDirectory();
+    while(!directory.isDirectory()) {
+        if(directory == boundary || !directory.isAChildOf(boundary)) {
+            return;
+        }
+        directory = directory.getParentDirectory();
+    }
+    watchDirectory(directory);
+}
+
+// Samples can move between conversions, so the set of directories is refreshed after each
+void DSWatcher::updateWatches() {
+    for (auto *instrument : instruments) {
+        const juce::File instrumentDirectory = getSourceFile(instrument->job).getParentDirectory();
+        for (auto &file : getInputFiles(*instrument)) {
+            watchParentDirectory(file, instrumentDirectory);
+        }
+        for (auto &file : getSampleDependencies(*instrument)) {
+            watchParentDirectory(file, instrumentDirectory);
+        }
+    }
+}
+
+bool DSWatcher::run() {
+    inotifyHandle = inotify_init1(IN_CLOEXEC);
+    if(inotifyHandle < 0) {
+        std::cerr << "error: could not start watching for changes." << std::endl;
+        return false;
+    }
+    
+    juce::Array<WatchedInstrument *> everything;
+    for (auto *instrument : instruments) {
+        everything.add(instrument);
+    }
+    convert(everything, {});
+    updateWatches();
+    std::cout << "Watching " << (int) watchedDirectories.size() << " directories for changes." << std::endl;
+    
+    alignas(struct inotify_event) char buffer[65536];
+    std::set<juce::String> changedFiles;
+    
+    for (;;) {
+        // Wait indefinitely for the first change, then until things have been quiet for a while
+        pollfd descriptor { inotifyHandle, POLLIN, 0 };
+        int ready = poll(&descriptor, 1, changedFiles.empty() ? -1 : debounceMilliseconds);
+        if(ready < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return true;
+        }
+        
+        if(ready > 0) {
+            ssize_t length = read(inotifyHandle, buffer, sizeof(buffer));
+            if(length <= 0) {
+                return true;
+            }
+            bool watchesRemoved = false;
+            for (char *p = buffer; p < buffer + length; ) {
+                auto *event = reinterpret_cast<struct inotify_event *>(p);
+                // Events were dropped, so there's no telling what changed
+                if(event->mask & IN_Q_OVERFLOW) {
+                    for (auto *instrument : instruments) {
+                        changedFiles.insert(getSourceFile(instrument->job).getFullPathName());
+                    }
+                }
+                auto directory = watchedDirectories.find(event->wd);
+                if(directory != watchedDirectories.end() && event->len > 0) {
+                    changedFiles.insert(directory->second.getChildFile(event->name).getFullPathName());
+                }
+                // The directory was deleted or unmounted. Forgetting it lets it be watched
+                // again if it comes back, which its parent's watch will notice.
+                if(event->mask & IN_IGNORED) {
+                    watchedDirectories.erase(event->wd);
+                    watchesRemoved = true;
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+            if(watchesRemoved) {
+                updateWatches();
+            }
+            continue;
+        }
+        
+        // Quiet for the debounce interval: convert whatever was affected
+        juce::Array<WatchedInstrument *> affected;
+        std::set<juce::String> changedInputs;
+        for (auto *instrument : instruments) {
+            bool changed = false;
+            for (auto &file : getInputFiles(*instrument)) {
+                changed = changed || isAffected(file, changedFiles);
+            }
+            if(changed) {
+                changedInputs.insert(getSourceFile(instrument->job).getFullPathName());
+            }
+            for (auto &file : getSampleDependencies(*instrument)) {
+                changed = changed || isAffected(file, changedFiles);
+            }
+            if(changed) {
+                affected.add(instrument);
+            }
+        }
+        changedFiles.clear();
+        
+        if(!affected.isEmpty()) {
+            convert(affected, changedInputs);
+            updateWatches();
+        }
+    }
+}
+
+#else
+
+void DSWatcher::watchDirectory(const juce::File &) {
+}
+
+void DSWatcher::watchParentDirectory(const juce::File &, const juce::File &) {
+}
+
+void DSWatcher::updateWatches() {
+}
+
+bool DSWatcher::run() {
+    std::cerr << "error: --watch needs inotify, which is only available on Linux." << std::endl;
+    return false;
+}
+
+#endif
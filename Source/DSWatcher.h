@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    DSWatcher.h
+    Created: 18 Oct 2026 9:14:02pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DSBatchConverter.h"
+#include <set>
+
+// Converts a set of instruments and then keeps them up to date: whenever an input file, a
+// file it #includes or one of the samples it uses is written, or a sample that was missing
+// turns up, the instrument is converted again. Bursts of
+// writes (a save touching many files, a sample folder being copied in) are collected
+// until the directories have been quiet for the debounce interval. An instrument whose
+// input didn't change is reconverted from its already-parsed form.
+//
+// Uses inotify, so it's only available on Linux.
+class DSWatcher {
+public:
+    DSWatcher(DSBatchConverter &converter, int debounceMilliseconds = 500);
+    ~DSWatcher();
+    
+    static bool isSupported();
+    
+    // Runs until the watch can't continue; returns false if it couldn't be started.
+    bool run();
+    
+private:
+    struct WatchedInstrument {
+        DSConversionJob job;
+        DSParsedInstrument parsed;
+        bool isParsed = false;
+        juce::Array<juce::File> sampleFiles;
+        // Where the samples that couldn't be found were looked for
+        juce::Array<juce::File> missingSampleFiles;
+    };
+    
+    static juce::File getSourceFile(const DSConversionJob &job);
+    // The files that mean the instrument has to be parsed again, and those that only mean
+    // it has to be rendered again
+    static juce::Array<juce::File> getInputFiles(const WatchedInstrument &instrument);
+    static juce::Array<juce::File> getSampleDependencies(const WatchedInstrument &instrument);
+    static bool isAffected(const juce::File &file, const std::set<juce::String> &changedFiles);
+    void convert(juce::Array<WatchedInstrument *> instruments, const std::set<juce::String> &changedInputs);
+    void watchDirectory(const juce::File &directory);
+    void watchParentDirectory(const juce::File &file, const juce::File &boundary);
+    void updateWatches();
+    
+    DSBatchConverter &converter;
+    int debounceMilliseconds;
+    juce::OwnedArray<WatchedInstrument> instruments;
+    int inotifyHandle = -1;
+    std::map<int, juce::File> watchedDirectories;
+};
@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    DSZipSampleResolver.cpp
+    Created: 18 Oct 2026 9:52:36pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSZipSampleResolver.h"
+
+// An entry name that's claimed by more than one entry
+static const int ambiguousEntry = -2;
+
+DSZipArchive::DSZipArchive(const juce::File &archiveFile_)
+    : archiveFile(archiveFile_),
+      zipFile(archiveFile_) {
+    for (int i = 0; i < zipFile.getNumEntries(); i++) {
+        const juce::String path = normalisePath(zipFile.getEntry(i)->filename);
+        if(path.isEmpty() || path.endsWith("/")) {
+            continue;
+        }
+        entriesByPath[path] = i;
+        
+        const juce::String fileName = path.fromLastOccurrenceOf("/", false, false);
+        auto found = entriesByFileName.find(fileName);
+        entriesByFileName[fileName] = found == entriesByFileName.end() ? i : ambiguousEntry;
+    }
+}
+
+// Lower case, forward slashes, no leading slash and no . or .. components
+juce::String DSZipArchive::normalisePath(const juce::String &path) {
+    juce::StringArray components = juce::StringArray::fromTokens(path.replace("\\", "/").toLowerCase(), "/", "");
+    juce::StringArray normalised;
+    for (auto &component : components) {
+        if(component.isEmpty() || component == ".") {
+            continue;
+        }
+        if(component == "..") {
+            normalised.remove(normalised.size() - 1);
+            continue;
+        }
+        normalised.add(component);
+    }
+    return normalised.joinIntoString("/");
+}
+
+juce::String DSZipArchive::getEntryPath(const juce::File &virtualFile) const {
+    return virtualFile.getRelativePathFrom(archiveFile).replace("\\", "/");
+}
+
+int DSZipArchive::findEntry(const juce::String &entryPath) const {
+    auto found = entriesByPath.find(normalisePath(entryPath));
+    return found != entriesByPath.end() ? found->second : -1;
+}
+
+int DSZipArchive::findEntryByFileName(const juce::String &fileName) const {
+    auto found = entriesByFileName.find(normalisePath(fileName));
+    return found != entriesByFileName.end() && found->second != ambiguousEntry ? found->second : -1;
+}
+
+juce::String DSZipArchive::getEntryName(int index) const {
+    return zipFile.getEntry(index)->filename.replace("\\", "/");
+}
+
+std::unique_ptr<juce::InputStream> DSZipArchive::createInputStream(int index) {
+    if(index < 0) {
+        return nullptr;
+    }
+    return std::unique_ptr<juce::InputStream>(zipFile.createStreamForEntry(index));
+}
+
+bool DSZipArchive::readEntry(int index, juce::MemoryBlock &data) {
+    std::unique_ptr<juce::InputStream> inputStream = createInputStream(index);
+    if(inputStream == nullptr) {
+        return false;
+    }
+    data.reset();
+    juce::int64 expectedSize = zipFile.getEntry(index)->uncompressedSize;
+    return inputStream->readIntoMemoryBlock(data) == (size_t) expectedSize;
+}
+
+DSZipSampleResolver::DSZipSampleResolver(std::shared_ptr<DSZipArchive> archive_, const juce::String &instrumentDirectory_)
+    : archive(archive_),
+      instrumentDirectory(DSZipArchive::normalisePath(instrumentDirectory_)) {
+}
+
+juce::String DSZipSampleResolver::resolveSample(const juce::String &path, const juce::String &sampleSetName) {
+    const juce::String base = instrumentDirectory.isEmpty() ? juce::String() : instrumentDirectory + "/";
+    const juce::String candidates[] = {
+        base + path,
+        base + sampleSetName + "/" + path,
+        base + "Samples/" + path,
+        path
+    };
+    
+    for (auto &candidate : candidates) {
+        int index = archive->findEntry(candidate);
+        if(index >= 0) {
+            return archive->getVirtualFile(archive->getEntryName(index)).getFullPathName();
+        }
+    }
+    
+    int index = archive->findEntryByFileName(path.replace("\\", "/").fromLastOccurrenceOf("/", false, false));
+    if(index >= 0) {
+        return archive->getVirtualFile(archive->getEntryName(index)).getFullPathName();
+    }
+    return juce::String();
+}
+
+std::unique_ptr<juce::InputStream> DSZipSampleResolver::openSample(const juce::String &resolvedPath) {
+    return archive->createInputStream(archive->findEntry(archive->getEntryPath(juce::File(resolvedPath))));
+}
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    DSZipSampleResolver.h
+    Created: 18 Oct 2026 9:52:36pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DSSampleResolver.h"
+#include <map>
+
+// A zip archive used as a read-only file system. Entries are looked up through an index
+// of the central directory that ignores case and the direction of slashes, and are read
+// straight out of the archive without being extracted. Thread-safe.
+class DSZipArchive {
+public:
+    DSZipArchive(const juce::File &archiveFile);
+    
+    bool isValid() const { return zipFile.getNumEntries() > 0; }
+    const juce::File &getFile() const { return archiveFile; }
+    
+    // The path of a file inside the archive, from the virtual path it has when the archive
+    // is treated as a directory: /libraries/Piano.zip/Samples/C3.wav -> Samples/C3.wav
+    juce::String getEntryPath(const juce::File &virtualFile) const;
+    juce::File getVirtualFile(const juce::String &entryPath) const { return archiveFile.getChildFile(entryPath); }
+    
+    // Returns -1 if there's no such entry
+    int findEntry(const juce::String &entryPath) const;
+    // Returns -1 unless exactly one entry has this file name
+    int findEntryByFileName(const juce::String &fileName) const;
+    juce::String getEntryName(int index) const;
+    
+    std::unique_ptr<juce::InputStream> createInputStream(int index);
+    bool readEntry(int index, juce::MemoryBlock &data);
+    
+    static juce::String normalisePath(const juce::String &path);
+    
+private:
+    juce::File archiveFile;
+    juce::ZipFile zipFile;
+    std::map<juce::String, int> entriesByPath;
+    std::map<juce::String, int> entriesByFileName;
+};
+
+// Hunts for samples inside an archive, relative to the directory of the instrument that
+// refers to them: as given, in <set name>/, in Samples/, and failing that anywhere in the
+// archive as long as the file name is unambiguous. Resolved paths are virtual paths below
+// the archive file (see DSZipArchive::getEntryPath), so they still read like file paths.
+class DSZipSampleResolver : public DSSampleResolver {
+public:
+    DSZipSampleResolver(std::shared_ptr<DSZipArchive> archive, const juce::String &instrumentDirectory);
+    
+    juce::String resolveSample(const juce::String &path, const juce::String &sampleSetName) override;
+    std::unique_ptr<juce::InputStream> openSample(const juce::String &resolvedPath) override;
+    
+private:
+    std::shared_ptr<DSZipArchive> archive;
+    juce::String instrumentDirectory;
+};
@@ -0,0 +1,238 @@
+/*
+  ==============================================================================
+
+    DSZipWriter.cpp
+    Created: 18 Oct 2026 10:37:09pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#include "DSZipWriter.h"
+#include "DSConversionStats.h"
+
+#include <array>
+
+// Anything at or above these doesn't fit a classic zip record and moves into Zip64 fields
+static const juce::int64 zip32SizeLimit = 0xffffffffLL;
+static const int zip32EntryLimit = 0xffff;
+
+// Deflating has to save at least this much for compressionAuto to keep it
+static const double minimumDeflateSaving = 0.05;
+
+// Version 4.5 is the first with Zip64; plain entries only need 2.0 (deflate)
+static const int versionZip64 = 45;
+static const int versionDeflate = 20;
+
+// Bit 11: names are UTF-8
+static const int flagUTF8Names = 0x0800;
+
+DSZipWriter::DSZipWriter(std::unique_ptr<juce::OutputStream> outputStream)
+    : output(std::move(outputStream)) {
+    juce::Time now = juce::Time::getCurrentTime();
+    dosTime = (juce::uint16) ((now.getHours() << 11) | (now.getMinutes() << 5) | (now.getSeconds() / 2));
+    dosDate = (juce::uint16) (((juce::jmax(1980, now.getYear()) - 1980) << 9) | ((now.getMonth() + 1) << 5) | now.getDayOfMonth());
+}
+
+DSZipWriter::~DSZipWriter() {
+    finish();
+}
+
+juce::uint32 DSZipWriter::crc32(const void *data, size_t numBytes, juce::uint32 crc) {
+    static const auto table = [] {
+        std::array<juce::uint32, 256> entries {};
+        for (juce::uint32 i = 0; i < 256; i++) {
+            juce::uint32 value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? (0xedb88320u ^ (value >> 1)) : (value >> 1);
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+    
+    auto *bytes = static_cast<const juce::uint8 *>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < numBytes; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+DSZipWriter::PreparedEntry DSZipWriter::prepareEntry(const juce::String &name, const void *data, size_t numBytes, Compression compression) {
+    PreparedEntry entry;
+    entry.name = name;
+    entry.crc = crc32(data, numBytes);
+    entry.uncompressedSize = (juce::int64) numBytes;
+    
+    if(compression != compressionStored && numBytes > 0) {
+        juce::MemoryOutputStream deflatedStream(entry.data, false);
+        {
+            juce::GZIPCompressorOutputStream compressor(deflatedStream, 6, juce::GZIPCompressorOutputStream::windowBitsRaw);
+            compressor.write(data, numBytes);
+        }
+        deflatedStream.flush();
+        entry.deflated = compression == compressionDeflated
+                      || (double) deflatedStream.getDataSize() <= (1.0 - minimumDeflateSaving) * (double) numBytes;
+        if(entry.deflated) {
+            entry.data.setSize(deflatedStream.getDataSize());
+            return entry;
+        }
+    }
+    
+    entry.data.replaceAll(data, numBytes);
+    return entry;
+}
+
+bool DSZipWriter::addEntry(const juce::String &name, const void *data, size_t numBytes, Compression compression) {
+    return addEntry(prepareEntry(name, data, numBytes, compression));
+}
+
+bool DSZipWriter::addEntry(const PreparedEntry &entry) {
+    const juce::ScopedLock scopedLock(lock);
+    if(finished || failed || output == nullptr) {
+        return false;
+    }
+    
+    CentralDirectoryEntry record;
+    record.name = entry.name;
+    record.crc = entry.crc;
+    record.compressedSize = (juce::int64) entry.data.getSize();
+    record.uncompressedSize = entry.uncompressedSize;
+    record.localHeaderOffset = position;
+    record.deflated = entry.deflated;
+    
+    // The local header's Zip64 field can only carry sizes, and always carries both
+    const bool zip64 = record.compressedSize >= zip32SizeLimit || record.uncompressedSize >= zip32SizeLimit;
+    const juce::MemoryBlock nameUTF8(entry.name.toRawUTF8(), entry.name.getNumBytesAsUTF8());
+    
+    juce::MemoryOutputStream header;
+    header.writeInt(0x04034b50);
+    header.writeShort((short) (zip64 ? versionZip64 : versionDeflate));
+    header.writeShort((short) flagUTF8Names);
+    header.writeShort((short) (entry.deflated ? 8 : 0));
+    header.writeShort((short) dosTime);
+    header.writeShort((short) dosDate);
+    header.writeInt((int) entry.crc);
+    header.writeInt((int) (zip64 ? zip32SizeLimit : record.compressedSize));
+    header.writeInt((int) (zip64 ? zip32SizeLimit : record.uncompressedSize));
+    header.writeShort((short) nameUTF8.getSize());
+    header.writeShort((short) (zip64 ? 20 : 0));
+    header.write(nameUTF8.getData(), nameUTF8.getSize());
+    if(zip64) {
+        header.writeShort(0x0001);
+        header.writeShort(16);
+        header.writeInt64(record.uncompressedSize);
+        header.writeInt64(record.compressedSize);
+    }
+    
+    if(!output->write(header.getData(), header.getDataSize())
+       || !output->write(entry.data.getData(), entry.data.getSize())) {
+        failed = true;
+        return false;
+    }
+    position += (juce::int64) header.getDataSize() + record.compressedSize;
+    DSConversionStats::count(DSConversionStats::counterBytesWritten, (juce::int64) header.getDataSize() + record.compressedSize);
+    entries.add(record);
+    return true;
+}
+
+void DSZipWriter::writeCentralDirectoryEntry(const CentralDirectoryEntry &entry) {
+    const bool uncompressedOverflows = entry.uncompressedSize >= zip32SizeLimit;
+    const bool compressedOverflows = entry.compressedSize >= zip32SizeLimit;
+    const bool offsetOverflows = entry.localHeaderOffset >= zip32SizeLimit;
+    const int zip64Size = (uncompressedOverflows ? 8 : 0) + (compressedOverflows ? 8 : 0) + (offsetOverflows ? 8 : 0);
+    const int version = zip64Size > 0 ? versionZip64 : versionDeflate;
+    const juce::MemoryBlock nameUTF8(entry.name.toRawUTF8(), entry.name.getNumBytesAsUTF8());
+    
+    juce::MemoryOutputStream record;
+    record.writeInt(0x02014b50);
+    record.writeShort((short) version);
+    record.writeShort((short) version);
+    record.writeShort((short) flagUTF8Names);
+    record.writeShort((short) (entry.deflated ? 8 : 0));
+    record.writeShort((short) dosTime);
+    record.writeShort((short) dosDate);
+    record.writeInt((int) entry.crc);
+    record.writeInt((int) (compressedOverflows ? zip32SizeLimit : entry.compressedSize));
+    record.writeInt((int) (uncompressedOverflows ? zip32SizeLimit : entry.uncompressedSize));
+    record.writeShort((short) nameUTF8.getSize());
+    record.writeShort((short) (zip64Size > 0 ? zip64Size + 4 : 0));
+    record.writeShort(0);   // comment length
+    record.writeShort(0);   // disk number
+    record.writeShort(0);   // internal attributes
+    record.writeInt(0);     // external attributes
+    record.writeInt((int) (offsetOverflows ? zip32SizeLimit : entry.localHeaderOffset));
+    record.write(nameUTF8.getData(), nameUTF8.getSize());
+    if(zip64Size > 0) {
+        record.writeShort(0x0001);
+        record.writeShort((short) zip64Size);
+        if(uncompressedOverflows)
+            record.writeInt64(entry.uncompressedSize);
+        if(compressedOverflows)
+            record.writeInt64(entry.compressedSize);
+        if(offsetOverflows)
+            record.writeInt64(entry.localHeaderOffset);
+    }
+    
+    if(!output->write(record.getData(), record.getDataSize())) {
+        failed = true;
+    }
+    position += (juce::int64) record.getDataSize();
+}
+
+bool DSZipWriter::finish() {
+    const juce::ScopedLock scopedLock(lock);
+    if(finished) {
+        return !failed;
+    }
+    finished = true;
+    if(output == nullptr || failed) {
+        return false;
+    }
+    
+    const juce::int64 centralDirectoryOffset = position;
+    for (auto &entry : entries) {
+        writeCentralDirectoryEntry(entry);
+    }
+    const juce::int64 centralDirectorySize = position - centralDirectoryOffset;
+    
+    const bool zip64 = entries.size() >= zip32EntryLimit
+                    || centralDirectoryOffset >= zip32SizeLimit
+                    || centralDirectorySize >= zip32SizeLimit;
+    
+    juce::MemoryOutputStream trailer;
+    if(zip64) {
+        const juce::int64 zip64EndOffset = position;
+        trailer.writeInt(0x06064b50);
+        trailer.writeInt64(44);                 // size of the rest of this record
+        trailer.writeShort((short) versionZip64);
+        trailer.writeShort((short) versionZip64);
+        trailer.writeInt(0);                    // this disk
+        trailer.writeInt(0);                    // disk with the central directory
+        trailer.writeInt64(entries.size());
+        trailer.writeInt64(entries.size());
+        trailer.writeInt64(centralDirectorySize);
+        trailer.writeInt64(centralDirectoryOffset);
+        
+        trailer.writeInt(0x07064b50);
+        trailer.writeInt(0);                    // disk with the Zip64 end record
+        trailer.writeInt64(zip64EndOffset);
+        trailer.writeInt(1);                    // number of disks
+    }
+    
+    trailer.writeInt(0x06054b50);
+    trailer.writeShort(0);
+    trailer.writeShort(0);
+    trailer.writeShort((short) juce::jmin(entries.size(), zip32EntryLimit));
+    trailer.writeShort((short) juce::jmin(entries.size(), zip32EntryLimit));
+    trailer.writeInt((int) juce::jmin(centralDirectorySize, zip32SizeLimit));
+    trailer.writeInt((int) juce::jmin(centralDirectoryOffset, zip32SizeLimit));
+    trailer.writeShort(0);                      // comment length
+    
+    if(!output->write(trailer.getData(), trailer.getDataSize())) {
+        failed = true;
+    }
+    output->flush();
+    return !failed;
+}
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    DSZipWriter.h
+    Created: 18 Oct 2026 10:37:09pm
+    Author:  David Hilowitz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Writes a zip archive front to back into a stream that never has to seek, so entries can
+// be added as they're produced. Each entry is prepared (checksummed and, if worthwhile,
+// deflated) on whichever thread has it, and then appended in one go. Archives past 4 GB
+// or 65535 entries get Zip64 records.
+class DSZipWriter {
+public:
+    enum Compression {
+        compressionStored,
+        compressionDeflated,
+        // Deflated, unless that doesn't save at least a few percent
+        compressionAuto
+    };
+    
+    struct PreparedEntry {
+        juce::String name;
+        juce::MemoryBlock data;
+        juce::uint32 crc = 0;
+        juce::int64 uncompressedSize = 0;
+        bool deflated = false;
+    };
+    
+    DSZipWriter(std::unique_ptr<juce::OutputStream> outputStream);
+    ~DSZipWriter();
+    
+    // Checksums and compresses an entry. Touches nothing shared, so it can run anywhere.
+    static PreparedEntry prepareEntry(const juce::String &name, const void *data, size_t numBytes, Compression compression);
+    
+    // Appends a prepared entry. Safe to call from several threads; entries are written in
+    // the order the calls arrive.
+    bool addEntry(const PreparedEntry &entry);
+    bool addEntry(const juce::String &name, const void *data, size_t numBytes, Compression compression);
+    
+    // Writes the central directory. Nothing can be added afterwards.
+    bool finish();
+    
+    static juce::uint32 crc32(const void *data, size_t numBytes, juce::uint32 crc = 0);
+    
+private:
+    struct CentralDirectoryEntry {
+        juce::String name;
+        juce::uint32 crc;
+        juce::int64 compressedSize;
+        juce::int64 uncompressedSize;
+        juce::int64 localHeaderOffset;
+        bool deflated;
+    };
+    
+    void writeCentralDirectoryEntry(const CentralDirectoryEntry &entry);
+    
+    juce::CriticalSection lock;
+    std::unique_ptr<juce::OutputStream> output;
+    juce::int64 position = 0;
+    juce::Array<CentralDirectoryEntry> entries;
+    juce::uint16 dosTime = 0;
+    juce::uint16 dosDate = 0;
+    bool finished = false;
+    bool failed = false;
+};
@@ -9,8 +9,90 @@
 #include <JuceHeader.h>
 #include "DSEXS24.h"
 #include "DSPresetConverter.h"
+#include "DSBatchConverter.h"
+#include "DSInMemoryConverter.h"
+#include "DSConversionDaemon.h"
+#include "DSWatcher.h"
+#include "DSStandardStreams.h"
 #include <tclap/CmdLine.h>
 
+// EXS files are small; anything claiming to be bigger than this is a corrupt stream
+static const juce::uint32 maxStreamedInstrumentSize = 256 * 1024 * 1024;
+
+static DSPresetConverter::OutputFormat parseOutputFormatName(const std::string &name) {
+    if(name == "dspreset")
+        return DSPresetConverter::outputFormatDSPreset;
+    if(name == "json")
+        return DSPresetConverter::outputFormatJSON;
+    return DSPresetConverter::outputFormatSFZ;
+}
+
+// Writes the spans recorded for --trace once main returns, whichever way it returns
+struct DSTraceWriter {
+    juce::File traceFile;
+    ~DSTraceWriter() {
+        if(traceFile != juce::File()) {
+            DSTrace::stop();
+            DSTrace::writeJSON(traceFile);
+        }
+    }
+};
+
+// Writes the --stats line of an instrument converted in memory, in the same form as the
+// lines written by DSBatchConverter
+static void writeStatsLine(juce::OutputStream *statsOutput, const DSConversionStats &stats, const juce::String &input, const juce::String &output, bool succeeded) {
+    if(statsOutput == nullptr) {
+        return;
+    }
+    auto *report = new juce::DynamicObject();
+    juce::var reportVar(report);
+    report->setProperty("type", "instrument");
+    report->setProperty("input", input);
+    report->setProperty("outputs", juce::Array<juce::var> { output });
+    report->setProperty("succeeded", succeeded);
+    stats.addToJSON(*report);
+    statsOutput->writeText(juce::JSON::toString(reportVar, true) + "\n", false, false, nullptr);
+    statsOutput->flush();
+}
+
+// Answers each length-prefixed EXS instrument on stdin with a length-prefixed preset on
+// stdout until stdin is closed. Lengths are 32-bit big-endian; a reply of length 0 means
+// that instrument couldn't be converted.
+static int runStreamMode(DSInMemoryConverter &converter, const juce::String &sampleSetName, DSPresetConverter::OutputFormat format, juce::OutputStream *statsOutput) {
+    DSStandardStreams::sendInfoToStandardError();
+    DSStandardStreams::Output output;
+    
+    for (;;) {
+        juce::uint8 header[4];
+        if(!DSStandardStreams::readExactly(header, sizeof(header))) {
+            return 0;
+        }
+        
+        juce::uint32 length = juce::ByteOrder::bigEndianInt(header);
+        if(length > maxStreamedInstrumentSize) {
+            std::cerr << "error: streamed instrument claims to be " << (juce::int64) length << " bytes long." << std::endl;
+            return 2;
+        }
+        
+        juce::MemoryBlock exsData(length);
+        if(!DSStandardStreams::readExactly(exsData.getData(), length)) {
+            std::cerr << "error: stdin ended in the middle of an instrument." << std::endl;
+            return 2;
+        }
+        
+        juce::MemoryBlock preset;
+        DSConversionStats stats;
+        bool succeeded = converter.convertEXS(exsData.getData(), exsData.getSize(), sampleSetName, format, preset, statsOutput != nullptr ? &stats : nullptr);
+        if(!succeeded) {
+            preset.reset();
+        }
+        writeStatsLine(statsOutput, stats, "-", "-", succeeded);
+        output.writeIntBigEndian((int) preset.getSize());
+        output.write(preset.getData(), preset.getSize());
+        output.flush();
+    }
+}
+
 int main (int argc, char* argv[])
 {
     // Wrap everything in a try block.  Do this every time,
@@ -18,62 +100,268 @@ int main (int argc, char* argv[])
     try {
 
         TCLAP::CmdLine cmd("A command-line utility that converts Logic Sampler (EXS) files to SFZ format. At this point, it handles only the most basic mappings, but it's a start.", ' ', "0.1");
-        TCLAP::UnlabeledValueArg<std::string>  inputFileArg( "<exs-file>", "The EXS file to convert.", true, "", "exs-file"  );
+        TCLAP::UnlabeledValueArg<std::string>  inputFileArg( "<exs-file>", "The EXS (or SFZ) file to convert, or - to read an EXS file from stdin. Required unless --batch is used.", false, "", "exs-file"  );
         cmd.add( inputFileArg );
             
-        TCLAP::UnlabeledValueArg<std::string>  outputFileArg( "<sfz-file>", "The SFZ file to write out. WARNING: If the file already exists it will be overwritten.", true, "", "ds-preset-file"  );
+        TCLAP::UnlabeledValueArg<std::string>  outputFileArg( "<sfz-file>", "The SFZ file to write out, a .dspreset file to write a DecentSampler preset instead, a .dslibrary or .zip file to write a DecentSampler or SFZ bundle with its samples, or - to write to stdout. WARNING: If the file already exists it will be overwritten. Required unless --batch is used.", false, "", "ds-preset-file"  );
         cmd.add( outputFileArg );
         
+        TCLAP::MultiArg<std::string> extraOutputArg( "o", "output", "Also write this file from the same conversion. Can be given several times; the format follows the extension (.sfz, .dspreset or .json).", false, "output-file" );
+        cmd.add( extraOutputArg );
+        
         TCLAP::UnlabeledValueArg<std::string>  sampleDirectoryArg( "[sample-directory]", "If this optional value is specified, then the output file will look for sample files in this directory.", false, "", "sample-directory"  );
         cmd.add( sampleDirectoryArg );
+        
+        TCLAP::SwitchArg copySamplesArg( "c", "copy-samples", "Copy the samples into a Samples/<sfz-name>/ folder next to the SFZ file, burning any loop crossfades into the audio.", false );
+        cmd.add( copySamplesArg );
+        
+        std::vector<std::string> formatNames { "sfz", "dspreset", "json" };
+        TCLAP::ValuesConstraint<std::string> formatConstraint( formatNames );
+        TCLAP::ValueArg<std::string> formatArg( "f", "format", "The format written to stdout (-) and by --stream. Files use their extension.", false, "sfz", &formatConstraint );
+        cmd.add( formatArg );
+        
+        TCLAP::SwitchArg streamArg( "", "stream", "Read a sequence of EXS files from stdin, each preceded by its length as a 32-bit big-endian integer, and answer each with its converted preset in the same framing on stdout. A reply of length 0 means the instrument failed. Samples are looked up relative to the current directory.", false );
+        cmd.add( streamArg );
+        
+        TCLAP::ValueArg<std::string> daemonArg( "", "daemon", "Keep running and serve conversion requests (one JSON object per line) on this Unix socket. Sample lookups and header probes are cached between requests.", false, "", "socket-path" );
+        cmd.add( daemonArg );
+        
+        TCLAP::ValueArg<std::string> archiveArg( "a", "archive", "Read the instruments and their samples from this zip file without extracting it. <exs-file> (and the instruments in a --batch list) are then paths inside the archive. Needs --copy-samples.", false, "", "zip-file" );
+        cmd.add( archiveArg );
+        
+        TCLAP::SwitchArg watchArg( "w", "watch", "After converting, keep watching the instruments and their samples and convert an instrument again whenever one of its files is written. Linux only.", false );
+        cmd.add( watchArg );
+        
+        TCLAP::ValueArg<std::string> batchArg( "b", "batch", "Convert every instrument listed in this file. Each line holds an EXS file, a tab, the SFZ file to write (several can be separated with |) and optionally another tab and a sample directory. The largest instruments are converted first.", false, "", "list-file" );
+        cmd.add( batchArg );
+        
+        TCLAP::ValueArg<int> jobsArg( "j", "jobs", "The number of instruments converted at the same time. Defaults to the number of CPU threads.", false, 0, "count" );
+        cmd.add( jobsArg );
+        
+        TCLAP::ValueArg<int> ioThreadsArg( "", "io-threads", "The number of threads used for finding, reading and writing sample files. Raise this for network storage. Defaults to " + std::to_string(DSConversionScheduler::getDefaultIOThreadCount()) + ".", false, 0, "count" );
+        cmd.add( ioThreadsArg );
+        
+        TCLAP::ValueArg<int> cpuThreadsArg( "", "cpu-threads", "The number of threads used for decoding, crossfading and encoding samples. Defaults to the number of CPU cores.", false, 0, "count" );
+        cmd.add( cpuThreadsArg );
+        
+        std::vector<std::string> ioBackendNames { "auto", "streams", "io_uring" };
+        TCLAP::ValuesConstraint<std::string> ioBackendConstraint( ioBackendNames );
+        TCLAP::ValueArg<std::string> ioBackendArg( "", "io-backend", "How sample files are read and written. io_uring is only available in Linux builds made with DS_USE_IO_URING=1; auto uses it when it is available.", false, "auto", &ioBackendConstraint );
+        cmd.add( ioBackendArg );
+        
+        TCLAP::SwitchArg noPageCacheArg( "", "no-page-cache", "Stream sample files through without leaving them in the operating system's page cache, so that migrating a large library doesn't slow down everything else on the machine. Linux only.", false );
+        cmd.add( noPageCacheArg );
+        
+        TCLAP::SwitchArg physicalOrderArg( "", "physical-order", "Read sample files in the order they are laid out on disk instead of region order. Meant for spinning disks, ideally with --io-threads 1. Linux only.", false );
+        cmd.add( physicalOrderArg );
+        
+        TCLAP::ValueArg<std::string> statsArg( "", "stats", "Write the time spent in each stage (parse, hunt, probe, render, emit) and its file, byte, reader and region counts to this file as one JSON object per line: one per instrument and, for batches, one for the whole run. - writes them to stdout.", false, "", "file" );
+        cmd.add( statsArg );
+        
+        TCLAP::ValueArg<std::string> traceArg( "", "trace", "Record when each thread parsed, hunted, probed, read, rendered, encoded and wrote what, and write it to this file in the Chrome trace-event format (open it in Perfetto or chrome://tracing). Each thread keeps only its most recent spans.", false, "", "file" );
+        cmd.add( traceArg );
+        
+        TCLAP::ValueArg<int> maxRSSArg( "", "max-rss", "Abort the largest conversion in progress whenever the process's resident memory goes over this many megabytes, so that one huge instrument fails instead of the whole batch being killed. The other instruments carry on.", false, 0, "megabytes" );
+        cmd.add( maxRSSArg );
+        
+        TCLAP::ValueArg<std::string> metricsArg( "", "metrics", "Keep this file updated with Prometheus metrics (conversions done and failed, samples rendered, bytes read and written, stage latencies and queue depths) for the node exporter's textfile collector. Give it a .prom extension.", false, "", "file" );
+        cmd.add( metricsArg );
+        
+        TCLAP::ValueArg<int> metricsIntervalArg( "", "metrics-interval", "How often the --metrics file is rewritten, in seconds. Defaults to 15.", false, 15, "seconds" );
+        cmd.add( metricsIntervalArg );
                   
         // Parse the argv array.
         cmd.parse( argc, argv );
-
-        juce::File inputFile = juce::File(inputFileArg.getValue());
-        if(!inputFile.existsAsFile()) {
-            std::cerr << "\"" << inputFileArg.getValue() << "\" is not a file." << std::endl;
+        
+        DSTraceWriter traceWriter;
+        if(traceArg.isSet()) {
+            traceWriter.traceFile = juce::File::getCurrentWorkingDirectory().getChildFile(traceArg.getValue());
+            DSTrace::setCurrentThreadName("Main");
+            DSTrace::start();
+        }
+        
+        DSSampleIO::Backend ioBackend = DSSampleIO::backendAuto;
+        DSSampleIO::parseBackendName(ioBackendArg.getValue(), ioBackend);
+        
+        DSConversionScheduler scheduler(ioThreadsArg.getValue(), cpuThreadsArg.getValue(), ioBackend);
+        scheduler.getSampleIO().setKeepOutOfPageCache(noPageCacheArg.getValue());
+        scheduler.getSampleIO().setReadInPhysicalOrder(physicalOrderArg.getValue());
+        DSBatchConverter batchConverter(scheduler, jobsArg.getValue());
+        
+        std::vector<std::string> outputPaths = extraOutputArg.getValue();
+        if(outputFileArg.isSet()) {
+            outputPaths.insert(outputPaths.begin(), outputFileArg.getValue());
+        }
+        bool outputIsStdout = std::find(outputPaths.begin(), outputPaths.end(), "-") != outputPaths.end();
+        
+        std::unique_ptr<juce::OutputStream> statsOutput;
+        if(statsArg.isSet()) {
+            if(statsArg.getValue() == "-") {
+                if(outputIsStdout || streamArg.getValue()) {
+                    std::cerr << "error: --stats - can't be combined with writing the preset to stdout." << std::endl;
+                    return 2;
+                }
+                DSStandardStreams::sendInfoToStandardError();
+                statsOutput = std::make_unique<DSStandardStreams::Output>();
+            } else {
+                juce::File statsFile = juce::File::getCurrentWorkingDirectory().getChildFile(statsArg.getValue());
+                statsFile.deleteFile();
+                auto fileStream = std::make_unique<juce::FileOutputStream>(statsFile);
+                if(!fileStream->openedOk()) {
+                    std::cerr << "error: could not write \"" << statsFile.getFullPathName() << "\"." << std::endl;
+                    return 2;
+                }
+                statsOutput = std::move(fileStream);
+            }
+            batchConverter.setStatsOutput(statsOutput.get());
+        }
+        
+        // Only file and batch conversions (--watch included) are watched by the memory monitor
+        if(maxRSSArg.getValue() > 0 && (daemonArg.isSet() || streamArg.getValue() || inputFileArg.getValue() == "-" || outputIsStdout)) {
+            std::cerr << "error: --max-rss can't be combined with --daemon, --stream or reading from stdin or writing to stdout." << std::endl;
             return 2;
         }
         
-        juce::File outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(outputFileArg.getValue());
-//        juce::String sampleDir;
-//        if(argc == 4) {
-//            sampleDir = argv[3];
-//        }
+        // Peak memory per stage is only worth sampling when it's reported or limited
+        std::unique_ptr<DSMemoryMonitor> memoryMonitor;
+        if(statsArg.isSet() || maxRSSArg.getValue() > 0) {
+            memoryMonitor = std::make_unique<DSMemoryMonitor>((juce::int64) juce::jmax(0, maxRSSArg.getValue()) * 1024 * 1024);
+            batchConverter.setMemoryMonitor(memoryMonitor.get());
+        }
         
-        DSEXS24 exs;
-        exs.loadExs(inputFile);
+        std::unique_ptr<DSMetricsFile> metricsFile;
+        if(metricsArg.isSet()) {
+            metricsFile = std::make_unique<DSMetricsFile>(juce::File::getCurrentWorkingDirectory().getChildFile(metricsArg.getValue()), scheduler, metricsIntervalArg.getValue());
+            batchConverter.setMetricsFile(metricsFile.get());
+        }
         
-        DSPresetConverter presetMaker;
-        presetMaker.parseDSEXS24(exs);
+        if(daemonArg.isSet()) {
+            DSConversionDaemon daemon(scheduler);
+            return daemon.run(juce::File::getCurrentWorkingDirectory().getChildFile(daemonArg.getValue())) ? 0 : 2;
+        }
         
+        if(streamArg.getValue()) {
+            DSFileSampleResolver resolver(juce::File::getCurrentWorkingDirectory());
+            DSInMemoryConverter converter(resolver, &scheduler);
+            return runStreamMode(converter, sampleDirectoryArg.getValue(), parseOutputFormatName(formatArg.getValue()), statsOutput.get());
+        }
+        
+        juce::File archiveFile;
+        if(archiveArg.isSet()) {
+            archiveFile = juce::File::getCurrentWorkingDirectory().getChildFile(archiveArg.getValue());
+            if(!archiveFile.existsAsFile()) {
+                std::cerr << "\"" << archiveArg.getValue() << "\" is not a file." << std::endl;
+                return 2;
+            }
+            if(juce::ZipFile(archiveFile).getNumEntries() == 0) {
+                std::cerr << "\"" << archiveArg.getValue() << "\" is not a zip archive, or is empty." << std::endl;
+                return 2;
+            }
+        }
+        
+        if(batchArg.isSet()) {
+            juce::File listFile = juce::File::getCurrentWorkingDirectory().getChildFile(batchArg.getValue());
+            if(!batchConverter.addJobsFromListFile(listFile, copySamplesArg.getValue(), archiveFile)) {
+                return 2;
+            }
+        }
         
-        juce::String possibleSampleDirectory = sampleDirectoryArg.getValue();
-        if(possibleSampleDirectory.isEmpty()) {
-            possibleSampleDirectory = inputFile.getFileNameWithoutExtension();
+        bool inputIsStdin = inputFileArg.getValue() == "-";
+        if((inputIsStdin || outputIsStdout) && archiveArg.isSet()) {
+            std::cerr << "error: --archive can't be combined with reading from stdin or writing to stdout." << std::endl;
+            return 2;
+        }
+        if(inputIsStdin || outputIsStdout) {
+            // Piped conversions run in memory and write their one output in a single go.
+            // The samples are only located, never copied, and are referred to by absolute path.
+            if(outputPaths.size() != 1 || copySamplesArg.getValue()) {
+                std::cerr << "error: reading from stdin or writing to stdout works with exactly one output and without --copy-samples." << std::endl;
+                return 2;
+            }
+            if(outputIsStdout) {
+                DSStandardStreams::sendInfoToStandardError();
+            }
+            
+            juce::MemoryBlock exsData;
+            juce::File inputDirectory = juce::File::getCurrentWorkingDirectory();
+            juce::String sampleSetName = sampleDirectoryArg.getValue();
+            if(inputIsStdin) {
+                if(!DSStandardStreams::readAll(exsData)) {
+                    std::cerr << "error: could not read stdin." << std::endl;
+                    return 2;
+                }
+            } else {
+                juce::File inputFile = inputDirectory.getChildFile(inputFileArg.getValue());
+                if(!inputFile.existsAsFile() || inputFile.hasFileExtension("sfz")) {
+                    std::cerr << "\"" << inputFileArg.getValue() << "\" is not an EXS file." << std::endl;
+                    return 2;
+                }
+                inputFile.loadFileAsData(exsData);
+                inputDirectory = inputFile.getParentDirectory();
+                if(sampleSetName.isEmpty()) {
+                    sampleSetName = inputFile.getFileNameWithoutExtension();
+                }
+            }
+            
+            DSFileSampleResolver resolver(inputDirectory);
+            DSInMemoryConverter converter(resolver, &scheduler);
+            juce::File outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(outputPaths.front());
+            DSPresetConverter::OutputFormat format = outputIsStdout ? parseOutputFormatName(formatArg.getValue()) : DSPresetConverter::getOutputFormatForFile(outputFile);
+            
+            juce::MemoryBlock preset;
+            DSConversionStats stats;
+            bool succeeded = converter.convertEXS(exsData.getData(), exsData.getSize(), sampleSetName, format, preset, statsOutput != nullptr ? &stats : nullptr);
+            writeStatsLine(statsOutput.get(), stats, inputIsStdin ? juce::String("-") : juce::File::getCurrentWorkingDirectory().getChildFile(inputFileArg.getValue()).getFullPathName(), outputIsStdout ? juce::String("-") : outputFile.getFullPathName(), succeeded);
+            if(!succeeded) {
+                return 4;
+            }
+            if(outputIsStdout) {
+                DSStandardStreams::Output output;
+                output.write(preset.getData(), preset.getSize());
+                output.flush();
+            } else if(!outputFile.replaceWithData(preset.getData(), preset.getSize())) {
+                std::cerr << "error: could not write \"" << outputFile.getFullPathName() << "\"." << std::endl;
+                return 4;
+            }
+            return 0;
         }
-        presetMaker.huntForSamples(inputFile.getParentDirectory(), possibleSampleDirectory);
         
-        presetMaker.convertEXSLoopCrossfadePoints();
+        if(inputFileArg.isSet() || !outputPaths.empty()) {
+            juce::File inputFile = (archiveArg.isSet() ? archiveFile : juce::File::getCurrentWorkingDirectory()).getChildFile(inputFileArg.getValue());
+            if(!archiveArg.isSet() && !inputFile.existsAsFile()) {
+                std::cerr << "\"" << inputFileArg.getValue() << "\" is not a file." << std::endl;
+                return 2;
+            }
+            if(outputPaths.empty()) {
+                std::cerr << "error: no <sfz-file> was given for \"" << inputFileArg.getValue() << "\"." << std::endl;
+                return 2;
+            }
+            
+            DSConversionJob job;
+            job.inputFile = inputFile;
+            job.archiveFile = archiveFile;
+            job.outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(outputPaths.front());
+            for (size_t i = 1; i < outputPaths.size(); i++) {
+                job.additionalOutputFiles.add(juce::File::getCurrentWorkingDirectory().getChildFile(outputPaths[i]));
+            }
+            job.sampleDirectory = sampleDirectoryArg.getValue();
+            job.copySamples = copySamplesArg.getValue();
+            batchConverter.addJob(job);
+        }
         
-        juce::String desiredSamplePath = sampleDirectoryArg.getValue();
-        if(desiredSamplePath.isNotEmpty())
-            presetMaker.convertPathsToDesiredDirectory(inputFile.getParentDirectory(), possibleSampleDirectory);
-        else
-            presetMaker.convertPathsToRelative(inputFile.getParentDirectory());
+        if(batchConverter.getNumJobs() == 0) {
+            std::cerr << "error: nothing to convert. Pass an <exs-file> and <sfz-file>, or use --batch." << std::endl;
+            return 2;
+        }
         
-        DBG(presetMaker.getSFZ());
-
+        if(watchArg.getValue()) {
+            DSWatcher watcher(batchConverter);
+            return watcher.run() ? 0 : 2;
+        }
         
-        if(outputFile.existsAsFile()) {
-            outputFile.deleteFile();
-    //        std::cerr << "File \"" << argv[1] << "\" exists already." << std::endl;
-    ////        return 3;
+        if(batchConverter.run() > 0) {
+            return 4;
         }
-    //
-        outputFile.create();
-        outputFile.appendText(presetMaker.getSFZ());
         
     } catch (TCLAP::ArgException &e)  // catch exceptions
     { std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl; }